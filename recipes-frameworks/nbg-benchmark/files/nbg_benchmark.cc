@@ -23,6 +23,9 @@
 #include <pthread.h>
 #include "vnn_utils.h"
 #include <sys/resource.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 #define MAX_INPUT_COUNT  32
 #define MAX_OUTPUT_COUNT 32
@@ -170,6 +173,29 @@ exit:
 	return status;
 }
 
+/**
+ * This function maps the network binary file in memory with read-only shared
+ * pages, so that the NBG is backed by the page cache instead of a private heap
+ * copy and is shared by all the processes using the same model.
+ * Returns NULL if the file cannot be mapped.
+ */
+static void* map_network_binary(const std::string& path, size_t* size)
+{
+	int fd = open(path.c_str(), O_RDONLY);
+	if (fd < 0)
+		return NULL;
+	struct stat st;
+	void* addr = MAP_FAILED;
+	if (fstat(fd, &st) == 0 && st.st_size > 0)
+		addr = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+	/* The mapping keeps its own reference on the file */
+	close(fd);
+	if (addr == MAP_FAILED)
+		return NULL;
+	*size = st.st_size;
+	return addr;
+}
+
 /* Get RAM Usage */
 std::size_t GetPeakWorkingSetSize(){
 	struct rusage rusage;
@@ -188,6 +214,8 @@ int main(int argc, char **argv){
 	vx_status  status       = VX_FAILURE;
 	vx_tensor  input_tensor = NULL;
 	std::size_t peak_memory = 0;
+	void*      nbg_map      = NULL;
+	size_t     nbg_size     = 0;
 
 	inout_obj inputs[MAX_INPUT_COUNT];
 	inout_obj outputs[MAX_OUTPUT_COUNT];
@@ -211,7 +239,14 @@ int main(int argc, char **argv){
 	graph = vxCreateGraph(context);
 	_CHECK_OBJ(graph, exit);
 
-	kernel = vxImportKernelFromURL(context, VX_VIVANTE_IMPORT_KERNEL_FROM_FILE, network_binary_file.c_str());
+	/* The mapping must stay valid as long as the kernel is in use */
+	nbg_map = map_network_binary(network_binary_file, &nbg_size);
+	if (nbg_map != NULL) {
+		kernel = vxImportKernelFromURL(context, VX_VIVANTE_IMPORT_KERNEL_FROM_POINTER, (const vx_char*)nbg_map);
+	} else {
+		std::cout << "Warning: Cannot map " << network_binary_file << ", importing it from file." << std::endl;
+		kernel = vxImportKernelFromURL(context, VX_VIVANTE_IMPORT_KERNEL_FROM_FILE, network_binary_file.c_str());
+	}
 	status = vxGetStatus((vx_reference)kernel);
 	_CHECK_STATUS(status, exit);
 
@@ -281,6 +316,8 @@ exit:
 		vxReleaseGraph(&graph);
 	if (context != NULL)
 		vxReleaseContext(&context);
+	if (nbg_map != NULL)
+		munmap(nbg_map, nbg_size);
 
 	return 0;
 }
\ No newline at end of file
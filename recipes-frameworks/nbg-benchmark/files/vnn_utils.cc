@@ -16,6 +16,9 @@
 
 #include <stdarg.h>
 #include "vnn_utils.h"
+#if defined(__aarch64__)
+#include <arm_neon.h>
+#endif
 
 #ifdef WIN32
 static vx_float32 round(vx_float32 x)
@@ -296,6 +299,51 @@ vx_float32 vnn_Fp16toFp32(const vx_uint16 in)
     return out;
 }
 
+/*
+ * Bulk conversions of the float16 tensors. On aarch64 the values are converted eight at a time
+ * with the NEON fcvt instructions, the float32 inputs being first clamped to HALF_MAX/HALF_MIN
+ * and their NaNs flushed to 0 as vnn_Fp32toFp16 does. Unlike the scalar versions the hardware
+ * keeps the float16 denormals instead of flushing them to zero. The remaining values, and all
+ * of them on other targets, go through the scalar conversions.
+ */
+void vnn_Fp16toFp32Array(const vx_uint16 *in, vx_float32 *out, vx_uint32 count)
+{
+    vx_uint32 i = 0;
+#if defined(__aarch64__)
+    for(; i + 8 <= count; i += 8)
+    {
+        uint16x8_t half = vld1q_u16(in + i);
+        vst1q_f32(out + i, vcvt_f32_f16(vreinterpret_f16_u16(vget_low_u16(half))));
+        vst1q_f32(out + i + 4, vcvt_f32_f16(vreinterpret_f16_u16(vget_high_u16(half))));
+    }
+#endif
+    for(; i < count; i++)
+        out[i] = vnn_Fp16toFp32(in[i]);
+}
+
+void vnn_Fp32toFp16Array(const vx_float32 *in, vx_int16 *out, vx_uint32 count)
+{
+    vx_uint32 i = 0;
+#if defined(__aarch64__)
+    const float32x4_t half_max = vdupq_n_f32(65504.0f);
+    const float32x4_t half_min = vdupq_n_f32(-65504.0f);
+    for(; i + 8 <= count; i += 8)
+    {
+        float32x4_t low = vld1q_f32(in + i);
+        float32x4_t high = vld1q_f32(in + i + 4);
+        /* NaN != NaN: replace them by 0, then clamp */
+        low = vreinterpretq_f32_u32(vandq_u32(vceqq_f32(low, low), vreinterpretq_u32_f32(low)));
+        high = vreinterpretq_f32_u32(vandq_u32(vceqq_f32(high, high), vreinterpretq_u32_f32(high)));
+        low = vminq_f32(vmaxq_f32(low, half_min), half_max);
+        high = vminq_f32(vmaxq_f32(high, half_min), half_max);
+        float16x8_t half = vcvt_high_f16_f32(vcvt_f16_f32(low), high);
+        vst1q_s16(out + i, vreinterpretq_s16_f16(half));
+    }
+#endif
+    for(; i < count; i++)
+        out[i] = vnn_Fp32toFp16(in[i]);
+}
+
 vx_uint32 vnn_GetTensorSize(vx_tensor tensor)
 {
     vx_uint32 size[6];
@@ -425,8 +473,7 @@ vx_status  vnn_CopyTensorToFloat32Data(vx_tensor tensor,vx_float32 **buf)
 	}
     else if(data_format == VX_TYPE_FLOAT16)/*VX_QUANT_NONE*/
     {
-         for(i = 0;i < num; i++)
-             (*buf)[i]= vnn_Fp16toFp32( ((vx_int16*)data)[i]);
+         vnn_Fp16toFp32Array((vx_uint16*)data, *buf, num);
     }
     else if(data_format == VX_TYPE_FLOAT32)/*VX_QUANT_NONE*/
     {
@@ -554,8 +601,7 @@ vx_status  vnn_CopyFloat32DataToTensor(vx_tensor tensor,vx_float32 *buf)
     }
     else if(data_format == VX_TYPE_FLOAT16)/*VX_QUANT_NONE*/
     {
-         for(i = 0;i < num; i++)
-             ((vx_int16*)data)[i] = vnn_Fp32toFp16(buf[i]);
+         vnn_Fp32toFp16Array(buf, (vx_int16*)data, num);
     }
     else if(data_format == VX_TYPE_FLOAT32)/*VX_QUANT_NONE*/
     {
@@ -86,6 +86,8 @@ vx_float32 vnn_Int16toFp32(vx_int16 val, vx_int8 fixedPointPos);
 vx_int16   vnn_Fp32toInt16(vx_float32 val, vx_int8 fixedPointPos);
 vx_int16   vnn_Fp32toFp16(vx_float32 val);
 vx_float32 vnn_Fp16toFp32(const vx_uint16 in);
+void       vnn_Fp16toFp32Array(const vx_uint16 *in, vx_float32 *out, vx_uint32 count);
+void       vnn_Fp32toFp16Array(const vx_float32 *in, vx_int16 *out, vx_uint32 count);
 vx_int8 vnn_Fp32toAsymInt8(vx_float32 val, vx_int32 zeroPoint, vx_float32 scale);
 vx_float32 vnn_AsymInt8toFp32(vx_int8 val, vx_int32 zeroPoint, vx_float32 scale);
 vx_int16 vnn_Fp32toAsymInt16(vx_float32 val, vx_int32 zeroPoint, vx_float32 scale);
@@ -14,11 +14,14 @@
  * inputs data fill with a default input tensor.
  * The application support common I/O types uint8, int8, float32, to support more types
  * please refer to the ONNX Runtime documentation
+ * The inputs and outputs are bound once to persistent buffers through an
+ * IoBinding, so that each run only executes the graph.
  */
 
 #include <stdio.h>
 #include <stdlib.h>
 #include <time.h>
+#include <chrono>
 #include <iostream>
 #include <thread>
 #include "onnxruntime_cxx_api.h"
@@ -55,6 +58,19 @@ void generate_input_data(ONNXTensorElementDataType type, std::vector<uint8_t>& u
     }
 }
 
+size_t get_element_size(ONNXTensorElementDataType type) {
+    switch (type) {
+        case ONNX_TENSOR_ELEMENT_DATA_TYPE_UINT8:
+            return sizeof(uint8_t);
+        case ONNX_TENSOR_ELEMENT_DATA_TYPE_INT8:
+            return sizeof(int8_t);
+        case ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT:
+            return sizeof(float);
+        default:
+            return 0;
+    }
+}
+
 void retrieve_output_data(ONNXTensorElementDataType type, const void* data, size_t size) {
     switch (type) {
         case ONNX_TENSOR_ELEMENT_DATA_TYPE_UINT8: {
@@ -92,7 +108,7 @@ void retrieve_output_data(ONNXTensorElementDataType type, const void* data, size
     }
 }
 
-void run_inference(const std::string& model_file) {
+void run_inference(const std::string& model_file, const std::string& profile_prefix) {
 
     /* create an environment and session options */
     Ort::Env ort_env(ORT_LOGGING_LEVEL_WARNING, "Onnx_environment");
@@ -116,13 +132,20 @@ void run_inference(const std::string& model_file) {
     session_options.DisableCpuMemArena();
     session_options.SetGraphOptimizationLevel(GraphOptimizationLevel::ORT_ENABLE_ALL);
 
+    /* ORT records the time of each node with the execution provider it ran on, and
+     * writes them in the Chrome trace JSON format when the profiling ends */
+    if (!profile_prefix.empty())
+        session_options.EnableProfiling(profile_prefix.c_str());
+
     /* create a session from the ONNX model file */
     Ort::Session session(ort_env, model_file.c_str(), session_options);
     if (session == nullptr) {
         ORT_CXX_API_THROW("", OrtErrorCode::ORT_NO_MODEL );
     }
 
-    Ort::MemoryInfo memory_info_ = Ort::MemoryInfo::CreateCpu(OrtAllocatorType::OrtArenaAllocator,
+    /* The I/O tensors wrap buffers owned by the application, the CPU arena
+     * being disabled */
+    Ort::MemoryInfo memory_info_ = Ort::MemoryInfo::CreateCpu(OrtAllocatorType::OrtDeviceAllocator,
                                                         OrtMemType::OrtMemTypeDefault);
 
     Ort::AllocatorWithDefaultOptions allocator;
@@ -195,11 +218,53 @@ void run_inference(const std::string& model_file) {
         output_shapes[i] = tensor_info.GetShape();
     }
 
-    // Run inference
-    std::vector<Ort::Value> output_tensors = session.Run(Ort::RunOptions{nullptr}, input_node_names.data(), input_tensors.data(), num_input_nodes, output_node_names.data(), num_output_nodes);
+    /* Bind the inputs and the outputs once. The outputs of static shape are
+     * preallocated, the others being allocated by ONNX Runtime at the first run */
+    Ort::IoBinding io_binding(session);
+    for (size_t i = 0; i < num_input_nodes; ++i)
+        io_binding.BindInput(input_node_names[i], input_tensors[i]);
+
+    std::vector<std::vector<uint8_t>> output_buffers(num_output_nodes);
+    for (size_t i = 0; i < num_output_nodes; ++i) {
+        size_t size = 1;
+        bool static_shape = true;
+        for (auto dim : output_shapes[i]) {
+            static_shape &= dim > 0;
+            size *= dim > 0 ? dim : 1;
+        }
+        size_t element_size = get_element_size(output_types[i]);
+        if (static_shape && element_size) {
+            output_buffers[i].resize(size * element_size);
+            Ort::Value output_tensor = Ort::Value::CreateTensor(memory_info_, output_buffers[i].data(),
+                                                                output_buffers[i].size(),
+                                                                output_shapes[i].data(), output_shapes[i].size(),
+                                                                output_types[i]);
+            io_binding.BindOutput(output_node_names[i], output_tensor);
+        } else {
+            io_binding.BindOutput(output_node_names[i], memory_info_);
+        }
+    }
+
+    /* Run inference. The first run includes the compilation of the graph by
+     * the execution provider, the second one only its execution */
+    Ort::RunOptions run_options;
+    for (int run = 0; run < 2; ++run) {
+        auto start = std::chrono::steady_clock::now();
+        session.Run(run_options, io_binding);
+        auto stop = std::chrono::steady_clock::now();
+        std::cout << (run == 0 ? "First" : "Next") << " inference time: "
+                  << std::chrono::duration<double, std::milli>(stop - start).count() << " ms" << std::endl;
+    }
+    io_binding.SynchronizeOutputs();
+    std::vector<Ort::Value> output_tensors = io_binding.GetOutputValues();
 
     std::cout << "Inference run successfully." << std::endl;
 
+    if (!profile_prefix.empty()) {
+        Ort::AllocatedStringPtr profile_file = session.EndProfilingAllocated(allocator);
+        std::cout << "Profile trace written to " << profile_file.get() << std::endl;
+    }
+
     // Retrieve and print output data for each output tensor
     for (size_t i = 0; i < num_output_nodes; ++i) {
         size_t size = 1;
@@ -212,12 +277,13 @@ void run_inference(const std::string& model_file) {
 }
 
 int main(int argc, char* argv[]) {
-    if (argc != 2) {
-        fprintf(stderr, "Usage: %s <model_file>\n", argv[0]);
+    if (argc != 2 && argc != 3) {
+        fprintf(stderr, "Usage: %s <model_file> [profile_prefix]\n", argv[0]);
         return 1;
     }
 
     std::string model_file = argv[1];
-    run_inference(model_file);
+    std::string profile_prefix = argc == 3 ? argv[2] : "";
+    run_inference(model_file, profile_prefix);
     return 0;
 }
\ No newline at end of file
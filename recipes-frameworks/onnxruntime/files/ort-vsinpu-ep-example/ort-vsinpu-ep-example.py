@@ -15,10 +15,14 @@ import onnxruntime as ort
 from timeit import default_timer as timer
 import os
 
-def run_inference(model_path):
+def run_inference(model_path, profile_prefix=None):
     # Load the ONNX model and create an inference session with VSI NPU execution provider
     session_options = ort.SessionOptions()
     session_options.graph_optimization_level = ort.GraphOptimizationLevel.ORT_ENABLE_ALL
+    # Per node timings with their execution provider, dumped as a Chrome trace JSON file
+    if profile_prefix:
+        session_options.enable_profiling = True
+        session_options.profile_file_prefix = profile_prefix
     session = ort.InferenceSession(model_path, sess_options=session_options, providers=['VSINPUExecutionProvider'])
 
     # Get input and output details
@@ -46,13 +50,17 @@ def run_inference(model_path):
     # Run the inference
     output_data = session.run(None, {input_name: input_data})
 
+    if profile_prefix:
+        print("Profile trace written to", session.end_profiling())
+
     return output_data
 
 if __name__ == "__main__":
     parser = argparse.ArgumentParser(description='Run inference on an ONNX model using ONNX Runtime and VSI NPU execution provider')
     parser.add_argument('model_path', type=str, help='Path to the ONNX model file')
+    parser.add_argument('--profile', type=str, default=None, metavar='PREFIX', help='Write a per node profile trace to PREFIX_<date>.json')
     args = parser.parse_args()
 
-    output = run_inference(args.model_path)
+    output = run_inference(args.model_path, args.profile)
     print("Inference done!")
     # print("Inference results:", output)
\ No newline at end of file
@@ -0,0 +1,463 @@
+/*
+ * Copyright (c) 2024 STMicroelectronics.
+ * All rights reserved.
+ *
+ * This software is licensed under terms that can be found in the LICENSE file
+ * in the root directory of this software component.
+ * If no LICENSE file comes with this software, it is provided AS-IS.
+ *
+ */
+
+#ifndef STAI_MPU_QUANT_H_
+#define STAI_MPU_QUANT_H_
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <type_traits>
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define STAI_MPU_QUANT_NEON 1
+#endif
+
+#include "stai_mpu_types.h"
+#include "stai_mpu_tensor.h"
+#include "stai_mpu_fp16.h"
+
+/*
+ * Quantization kernels working on the quantization parameters of the stai_mpu_tensor.
+ * The affine kernels compute real = (q - zero_point) * scale and q = round(real / scale) + zero_point,
+ * the dynamic fixed point kernels real = q * 2^-fixed_point_pos. The rounding is to the nearest,
+ * ties to even, and the quantized values are saturated to the range of their type. The uint8,
+ * int8 and int16 affine kernels are vectorized with NEON when available.
+ */
+
+namespace stai_mpu_quant_internal {
+
+template<typename T>
+inline T saturate(float value) {
+    float rounded = std::nearbyint(value);
+    if (rounded <= (float)std::numeric_limits<T>::min())
+        return std::numeric_limits<T>::min();
+    if (rounded >= (float)std::numeric_limits<T>::max())
+        return std::numeric_limits<T>::max();
+    return (T)rounded;
+}
+
+#ifdef STAI_MPU_QUANT_NEON
+/* Dequantizes 8 int16 lanes widened from the quantized type */
+inline void dequantize_s16x8(int16x8_t q, int32x4_t zero_point, float32x4_t scale, float* out) {
+    int32x4_t low = vsubq_s32(vmovl_s16(vget_low_s16(q)), zero_point);
+    int32x4_t high = vsubq_s32(vmovl_s16(vget_high_s16(q)), zero_point);
+    vst1q_f32(out, vmulq_f32(vcvtq_f32_s32(low), scale));
+    vst1q_f32(out + 4, vmulq_f32(vcvtq_f32_s32(high), scale));
+}
+#endif
+
+#ifdef STAI_MPU_QUANT_NEON
+/* Returns the mask of the 16 lanes of in above bound, the bound fitting in the type */
+template<typename T>
+inline uint8x16_t above_x16(const T* in, int32_t bound) {
+    if (std::is_same<T, uint8_t>::value)
+        return vcgtq_u8(vld1q_u8(reinterpret_cast<const uint8_t*>(in)), vdupq_n_u8((uint8_t)bound));
+    return vcgtq_s8(vld1q_s8(reinterpret_cast<const int8_t*>(in)), vdupq_n_s8((int8_t)bound));
+}
+
+inline bool any_x16(uint8x16_t mask) {
+#ifdef __aarch64__
+    return vmaxvq_u8(mask) != 0;
+#else
+    uint8x8_t folded = vorr_u8(vget_low_u8(mask), vget_high_u8(mask));
+    return vget_lane_u64(vreinterpret_u64_u8(folded), 0) != 0;
+#endif
+}
+#endif
+
+#if defined(STAI_MPU_QUANT_NEON) && defined(__aarch64__)
+/* Quantizes 8 floats to int32 lanes, rounding to the nearest, ties to even */
+inline void quantize_f32x8(const float* in, float32x4_t inv_scale, int32x4_t zero_point,
+                           int32x4_t* low, int32x4_t* high) {
+    *low = vaddq_s32(vcvtnq_s32_f32(vmulq_f32(vld1q_f32(in), inv_scale)), zero_point);
+    *high = vaddq_s32(vcvtnq_s32_f32(vmulq_f32(vld1q_f32(in + 4), inv_scale)), zero_point);
+}
+#endif
+
+}  // namespace stai_mpu_quant_internal
+
+/**
+ * @brief Dequantizes affine quantized values.
+ *
+ * @param in The quantized values, of type uint8_t, int8_t or int16_t.
+ * @param out The real values.
+ * @param count The number of values.
+ * @param scale The scale of the quantization.
+ * @param zero_point The zero point of the quantization.
+ */
+template<typename T>
+inline void stai_mpu_dequantize(const T* in, float* out, size_t count, float scale, int32_t zero_point) {
+    static_assert(std::is_integral<T>::value && sizeof(T) <= 2, "Only 8 and 16 bits types are supported");
+    size_t i = 0;
+#ifdef STAI_MPU_QUANT_NEON
+    const int32x4_t zp = vdupq_n_s32(zero_point);
+    const float32x4_t sc = vdupq_n_f32(scale);
+    if (std::is_same<T, uint8_t>::value) {
+        const uint8_t* in_u8 = reinterpret_cast<const uint8_t*>(in);
+        for (; i + 16 <= count; i += 16) {
+            uint8x16_t q = vld1q_u8(in_u8 + i);
+            stai_mpu_quant_internal::dequantize_s16x8(vreinterpretq_s16_u16(vmovl_u8(vget_low_u8(q))), zp, sc, out + i);
+            stai_mpu_quant_internal::dequantize_s16x8(vreinterpretq_s16_u16(vmovl_u8(vget_high_u8(q))), zp, sc, out + i + 8);
+        }
+    } else if (std::is_same<T, int8_t>::value) {
+        const int8_t* in_s8 = reinterpret_cast<const int8_t*>(in);
+        for (; i + 16 <= count; i += 16) {
+            int8x16_t q = vld1q_s8(in_s8 + i);
+            stai_mpu_quant_internal::dequantize_s16x8(vmovl_s8(vget_low_s8(q)), zp, sc, out + i);
+            stai_mpu_quant_internal::dequantize_s16x8(vmovl_s8(vget_high_s8(q)), zp, sc, out + i + 8);
+        }
+    } else if (std::is_same<T, int16_t>::value) {
+        const int16_t* in_s16 = reinterpret_cast<const int16_t*>(in);
+        for (; i + 8 <= count; i += 8)
+            stai_mpu_quant_internal::dequantize_s16x8(vld1q_s16(in_s16 + i), zp, sc, out + i);
+    }
+#endif
+    for (; i < count; i++)
+        out[i] = ((int32_t)in[i] - zero_point) * scale;
+}
+
+/**
+ * @brief Quantizes real values with an affine quantization.
+ *
+ * @param in The real values.
+ * @param out The quantized values, of type uint8_t, int8_t or int16_t.
+ * @param count The number of values.
+ * @param scale The scale of the quantization.
+ * @param zero_point The zero point of the quantization.
+ */
+template<typename T>
+inline void stai_mpu_quantize(const float* in, T* out, size_t count, float scale, int32_t zero_point) {
+    static_assert(std::is_integral<T>::value && sizeof(T) <= 2, "Only 8 and 16 bits types are supported");
+    const float inv_scale = 1.0f / scale;
+    size_t i = 0;
+#if defined(STAI_MPU_QUANT_NEON) && defined(__aarch64__)
+    const float32x4_t isc = vdupq_n_f32(inv_scale);
+    const int32x4_t zp = vdupq_n_s32(zero_point);
+    int32x4_t low, high;
+    if (std::is_same<T, uint8_t>::value) {
+        uint8_t* out_u8 = reinterpret_cast<uint8_t*>(out);
+        for (; i + 8 <= count; i += 8) {
+            stai_mpu_quant_internal::quantize_f32x8(in + i, isc, zp, &low, &high);
+            vst1_u8(out_u8 + i, vqmovun_s16(vcombine_s16(vqmovn_s32(low), vqmovn_s32(high))));
+        }
+    } else if (std::is_same<T, int8_t>::value) {
+        int8_t* out_s8 = reinterpret_cast<int8_t*>(out);
+        for (; i + 8 <= count; i += 8) {
+            stai_mpu_quant_internal::quantize_f32x8(in + i, isc, zp, &low, &high);
+            vst1_s8(out_s8 + i, vqmovn_s16(vcombine_s16(vqmovn_s32(low), vqmovn_s32(high))));
+        }
+    } else if (std::is_same<T, int16_t>::value) {
+        int16_t* out_s16 = reinterpret_cast<int16_t*>(out);
+        for (; i + 8 <= count; i += 8) {
+            stai_mpu_quant_internal::quantize_f32x8(in + i, isc, zp, &low, &high);
+            vst1q_s16(out_s16 + i, vcombine_s16(vqmovn_s32(low), vqmovn_s32(high)));
+        }
+    }
+#endif
+    for (; i < count; i++)
+        out[i] = stai_mpu_quant_internal::saturate<T>(in[i] * inv_scale + zero_point);
+}
+
+/**
+ * @brief Requantizes affine quantized values from one set of quantization parameters to another.
+ *
+ * @param in The input quantized values.
+ * @param in_scale The scale of the input quantization.
+ * @param in_zero_point The zero point of the input quantization.
+ * @param out The output quantized values.
+ * @param out_scale The scale of the output quantization.
+ * @param out_zero_point The zero point of the output quantization.
+ * @param count The number of values.
+ */
+template<typename TIn, typename TOut>
+inline void stai_mpu_requantize(const TIn* in, float in_scale, int32_t in_zero_point,
+                                TOut* out, float out_scale, int32_t out_zero_point, size_t count) {
+    /* Work by blocks to stay in the L1 cache */
+    float block[256];
+    for (size_t i = 0; i < count; i += 256) {
+        size_t n = count - i < 256 ? count - i : 256;
+        stai_mpu_dequantize(in + i, block, n, in_scale, in_zero_point);
+        stai_mpu_quantize(block, out + i, n, out_scale, out_zero_point);
+    }
+}
+
+/**
+ * @brief Dequantizes per-channel affine quantized values, laid out as [outer][channels][inner].
+ *
+ * @param in The quantized values.
+ * @param out The real values.
+ * @param outer The number of elements before the channel dimension.
+ * @param channels The number of channels.
+ * @param inner The number of elements after the channel dimension.
+ * @param scales The scale of each channel.
+ * @param zero_points The zero point of each channel.
+ */
+template<typename T>
+inline void stai_mpu_dequantize_per_channel(const T* in, float* out, size_t outer, size_t channels, size_t inner,
+                                            const float* scales, const int32_t* zero_points) {
+    for (size_t o = 0; o < outer; o++) {
+        for (size_t c = 0; c < channels; c++) {
+            size_t offset = (o * channels + c) * inner;
+            stai_mpu_dequantize(in + offset, out + offset, inner, scales[c], zero_points[c]);
+        }
+    }
+}
+
+/**
+ * @brief Quantizes real values with a per-channel affine quantization, laid out as [outer][channels][inner].
+ *
+ * @param in The real values.
+ * @param out The quantized values.
+ * @param outer The number of elements before the channel dimension.
+ * @param channels The number of channels.
+ * @param inner The number of elements after the channel dimension.
+ * @param scales The scale of each channel.
+ * @param zero_points The zero point of each channel.
+ */
+template<typename T>
+inline void stai_mpu_quantize_per_channel(const float* in, T* out, size_t outer, size_t channels, size_t inner,
+                                          const float* scales, const int32_t* zero_points) {
+    for (size_t o = 0; o < outer; o++) {
+        for (size_t c = 0; c < channels; c++) {
+            size_t offset = (o * channels + c) * inner;
+            stai_mpu_quantize(in + offset, out + offset, inner, scales[c], zero_points[c]);
+        }
+    }
+}
+
+/**
+ * @brief Dequantizes dynamic fixed point values.
+ *
+ * @param in The quantized values, of type int8_t or int16_t.
+ * @param out The real values.
+ * @param count The number of values.
+ * @param fixed_point_pos The fixed point position.
+ */
+template<typename T>
+inline void stai_mpu_dequantize_dfp(const T* in, float* out, size_t count, int8_t fixed_point_pos) {
+    /* A dynamic fixed point value is an affine one with a power of two scale and no zero point */
+    stai_mpu_dequantize(in, out, count, std::ldexp(1.0f, -fixed_point_pos), 0);
+}
+
+/**
+ * @brief Quantizes real values with a dynamic fixed point quantization.
+ *
+ * @param in The real values.
+ * @param out The quantized values, of type int8_t or int16_t.
+ * @param count The number of values.
+ * @param fixed_point_pos The fixed point position.
+ */
+template<typename T>
+inline void stai_mpu_quantize_dfp(const float* in, T* out, size_t count, int8_t fixed_point_pos) {
+    stai_mpu_quantize(in, out, count, std::ldexp(1.0f, -fixed_point_pos), 0);
+}
+
+/**
+ * @brief Converts a threshold on real values into a bound on affine quantized values, so that the
+ * raw values can be compared without being dequantized: (q - zero_point) * scale > threshold, as
+ * computed by stai_mpu_dequantize, holds exactly when q > bound.
+ *
+ * @param threshold The threshold on the real values.
+ * @param scale The scale of the quantization, positive.
+ * @param zero_point The zero point of the quantization.
+ * @return The bound, std::numeric_limits<T>::max() when no value is above the threshold and \
+ * std::numeric_limits<T>::min() - 1 when all the values are.
+ */
+template<typename T>
+inline int32_t stai_mpu_quantize_threshold(float threshold, float scale, int32_t zero_point) {
+    static_assert(std::is_integral<T>::value && sizeof(T) <= 2, "Only 8 and 16 bits types are supported");
+    const int32_t lowest = std::numeric_limits<T>::min();
+    const int32_t highest = std::numeric_limits<T>::max();
+    double estimate = std::floor(zero_point + (double)threshold / scale);
+    int32_t bound = (int32_t)std::max<double>(lowest - 1, std::min<double>(highest, estimate));
+    /* Fix the rounding of the estimate against the float computation of the kernels */
+    while (bound >= lowest && (float)(bound - zero_point) * scale > threshold)
+        bound--;
+    while (bound < highest && !((float)(bound + 1 - zero_point) * scale > threshold))
+        bound++;
+    return bound;
+}
+
+/**
+ * @brief Tells whether any 8 bits quantized value is above a bound.
+ *
+ * @param in The quantized values, of type uint8_t or int8_t.
+ * @param count The number of values.
+ * @param bound The bound, as returned by stai_mpu_quantize_threshold().
+ * @return True if a value is above the bound, false otherwise.
+ */
+template<typename T>
+inline bool stai_mpu_any_above(const T* in, size_t count, int32_t bound) {
+    static_assert(std::is_integral<T>::value && sizeof(T) == 1, "Only 8 bits types are supported");
+    if (bound >= (int32_t)std::numeric_limits<T>::max())
+        return false;
+    if (bound < (int32_t)std::numeric_limits<T>::min())
+        return count != 0;
+    size_t i = 0;
+#ifdef STAI_MPU_QUANT_NEON
+    for (; i + 16 <= count; i += 16) {
+        if (stai_mpu_quant_internal::any_x16(stai_mpu_quant_internal::above_x16(in + i, bound)))
+            return true;
+    }
+#endif
+    for (; i < count; i++) {
+        if ((int32_t)in[i] > bound)
+            return true;
+    }
+    return false;
+}
+
+/**
+ * @brief Finds the 8 bits quantized values above a bound. The values are compared 16 at a time,
+ * only the blocks holding a value above the bound being inspected one by one.
+ *
+ * @param in The quantized values, of type uint8_t or int8_t.
+ * @param count The number of values.
+ * @param bound The bound, as returned by stai_mpu_quantize_threshold().
+ * @param indices The indices of the values above the bound, in increasing order, room for count \
+ * indices being needed.
+ * @return The number of indices.
+ */
+template<typename T>
+inline size_t stai_mpu_find_above(const T* in, size_t count, int32_t bound, uint32_t* indices) {
+    static_assert(std::is_integral<T>::value && sizeof(T) == 1, "Only 8 bits types are supported");
+    size_t found = 0;
+    if (bound >= (int32_t)std::numeric_limits<T>::max())
+        return found;
+    size_t i = 0;
+#ifdef STAI_MPU_QUANT_NEON
+    if (bound >= (int32_t)std::numeric_limits<T>::min()) {
+        for (; i + 16 <= count; i += 16) {
+            if (!stai_mpu_quant_internal::any_x16(stai_mpu_quant_internal::above_x16(in + i, bound)))
+                continue;
+            for (size_t j = i; j < i + 16; j++) {
+                if ((int32_t)in[j] > bound)
+                    indices[found++] = (uint32_t)j;
+            }
+        }
+    }
+#endif
+    for (; i < count; i++) {
+        if ((int32_t)in[i] > bound)
+            indices[found++] = (uint32_t)i;
+    }
+    return found;
+}
+
+/**
+ * @brief Dequantizes the data of a tensor, according to its data type and quantization parameters.
+ * Float32 data is copied as is and float16 data is converted to float32.
+ *
+ * @param tensor The tensor information.
+ * @param in The tensor data.
+ * @param out The real values, of tensor.get_num_elements() elements.
+ * @param half_as_float True if the data of a FLOAT16 or BFLOAT16 tensor is already float32, as the \
+ * outputs returned by the OVX backend are, false if it is the raw half precision values.
+ * @throws std::runtime_error If the data type or the quantization type is not supported.
+ */
+inline void stai_mpu_dequantize(const stai_mpu_tensor& tensor, const void* in, float* out,
+                                bool half_as_float = false) {
+    size_t count = tensor.get_num_elements();
+    const stai_mpu_quant_params& qparams = tensor.get_qparams();
+    stai_mpu_dtype dtype = tensor.get_dtype();
+    if (dtype == stai_mpu_dtype::STAI_MPU_DTYPE_FLOAT32 || (half_as_float &&
+        (dtype == stai_mpu_dtype::STAI_MPU_DTYPE_FLOAT16 || dtype == stai_mpu_dtype::STAI_MPU_DTYPE_BFLOAT16))) {
+        std::memcpy(out, in, count * sizeof(float));
+        return;
+    }
+    if (dtype == stai_mpu_dtype::STAI_MPU_DTYPE_FLOAT16) {
+        stai_mpu_fp16_to_fp32_array(static_cast<const uint16_t*>(in), out, count);
+        return;
+    }
+    if (tensor.get_qtype() == stai_mpu_qtype::STAI_MPU_QTYPE_STATIC_AFFINE) {
+        float scale = qparams.static_affine.scale;
+        int32_t zero_point = (int32_t)qparams.static_affine.zero_point;
+        switch (dtype) {
+            case stai_mpu_dtype::STAI_MPU_DTYPE_UINT8:
+                return stai_mpu_dequantize(static_cast<const uint8_t*>(in), out, count, scale, zero_point);
+            case stai_mpu_dtype::STAI_MPU_DTYPE_INT8:
+                return stai_mpu_dequantize(static_cast<const int8_t*>(in), out, count, scale, zero_point);
+            case stai_mpu_dtype::STAI_MPU_DTYPE_INT16:
+                return stai_mpu_dequantize(static_cast<const int16_t*>(in), out, count, scale, zero_point);
+            default:
+                break;
+        }
+    } else if (tensor.get_qtype() == stai_mpu_qtype::STAI_MPU_QTYPE_DYNAMIC_FIXED_POINT) {
+        int8_t fixed_point_pos = qparams.dfp.fixed_point_pos;
+        switch (dtype) {
+            case stai_mpu_dtype::STAI_MPU_DTYPE_INT8:
+                return stai_mpu_dequantize_dfp(static_cast<const int8_t*>(in), out, count, fixed_point_pos);
+            case stai_mpu_dtype::STAI_MPU_DTYPE_INT16:
+                return stai_mpu_dequantize_dfp(static_cast<const int16_t*>(in), out, count, fixed_point_pos);
+            default:
+                break;
+        }
+    }
+    throw std::runtime_error("[QUANT] Unsupported data type or quantization type for the tensor " + tensor.get_name());
+}
+
+/**
+ * @brief Quantizes real values into the data of a tensor, according to its data type and quantization
+ * parameters. Float32 data is copied as is and float16 data is converted from float32.
+ *
+ * @param tensor The tensor information.
+ * @param in The real values, of tensor.get_num_elements() elements.
+ * @param out The tensor data.
+ * @param half_as_float True to write float32 data for a FLOAT16 or BFLOAT16 tensor, as the inputs \
+ * given to the OVX backend have to be, false to write the raw half precision values.
+ * @throws std::runtime_error If the data type or the quantization type is not supported.
+ */
+inline void stai_mpu_quantize(const stai_mpu_tensor& tensor, const float* in, void* out,
+                              bool half_as_float = false) {
+    size_t count = tensor.get_num_elements();
+    const stai_mpu_quant_params& qparams = tensor.get_qparams();
+    stai_mpu_dtype dtype = tensor.get_dtype();
+    if (dtype == stai_mpu_dtype::STAI_MPU_DTYPE_FLOAT32 || (half_as_float &&
+        (dtype == stai_mpu_dtype::STAI_MPU_DTYPE_FLOAT16 || dtype == stai_mpu_dtype::STAI_MPU_DTYPE_BFLOAT16))) {
+        std::memcpy(out, in, count * sizeof(float));
+        return;
+    }
+    if (dtype == stai_mpu_dtype::STAI_MPU_DTYPE_FLOAT16) {
+        stai_mpu_fp32_to_fp16_array(in, static_cast<uint16_t*>(out), count);
+        return;
+    }
+    if (tensor.get_qtype() == stai_mpu_qtype::STAI_MPU_QTYPE_STATIC_AFFINE) {
+        float scale = qparams.static_affine.scale;
+        int32_t zero_point = (int32_t)qparams.static_affine.zero_point;
+        switch (dtype) {
+            case stai_mpu_dtype::STAI_MPU_DTYPE_UINT8:
+                return stai_mpu_quantize(in, static_cast<uint8_t*>(out), count, scale, zero_point);
+            case stai_mpu_dtype::STAI_MPU_DTYPE_INT8:
+                return stai_mpu_quantize(in, static_cast<int8_t*>(out), count, scale, zero_point);
+            case stai_mpu_dtype::STAI_MPU_DTYPE_INT16:
+                return stai_mpu_quantize(in, static_cast<int16_t*>(out), count, scale, zero_point);
+            default:
+                break;
+        }
+    } else if (tensor.get_qtype() == stai_mpu_qtype::STAI_MPU_QTYPE_DYNAMIC_FIXED_POINT) {
+        int8_t fixed_point_pos = qparams.dfp.fixed_point_pos;
+        switch (dtype) {
+            case stai_mpu_dtype::STAI_MPU_DTYPE_INT8:
+                return stai_mpu_quantize_dfp(in, static_cast<int8_t*>(out), count, fixed_point_pos);
+            case stai_mpu_dtype::STAI_MPU_DTYPE_INT16:
+                return stai_mpu_quantize_dfp(in, static_cast<int16_t*>(out), count, fixed_point_pos);
+            default:
+                break;
+        }
+    }
+    throw std::runtime_error("[QUANT] Unsupported data type or quantization type for the tensor " + tensor.get_name());
+}
+
+#endif //STAI_MPU_QUANT_H_
@@ -0,0 +1,217 @@
+/*
+ * Copyright (c) 2024 STMicroelectronics.
+ * All rights reserved.
+ *
+ * This software is licensed under terms that can be found in the LICENSE file
+ * in the root directory of this software component.
+ * If no LICENSE file comes with this software, it is provided AS-IS.
+ *
+ */
+
+#ifndef STAI_MPU_SCHEDULER_H_
+#define STAI_MPU_SCHEDULER_H_
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+#include "stai_mpu_network.h"
+#include "stai_mpu_stats.h"
+
+/**
+ * @brief Outcome of a job submitted to a @ref stai_mpu_scheduler "stai_mpu_scheduler".
+ */
+enum class stai_mpu_job_status {
+    STAI_MPU_JOB_DONE,
+    STAI_MPU_JOB_FAILED,
+    STAI_MPU_JOB_EXPIRED,
+    STAI_MPU_JOB_CANCELLED
+};
+
+/**
+ * @brief A scheduler owning the accelerator queue of a process. The jobs of all the networks are \
+ * executed one at a time on a single thread, highest priority first, then earliest deadline \
+ * first, then in submission order. A job still queued when its deadline passes is dropped \
+ * without being run. The submitting threads get a future and can carry on with their CPU work \
+ * while the job waits and runs. A network must only be used from the jobs of one scheduler.
+ */
+class stai_mpu_scheduler {
+public:
+    using clock = std::chrono::steady_clock;
+
+    /**
+     * @brief Starts the thread executing the jobs.
+     *
+     * @param cpu_affinity_mask The mask of the CPU cores the thread may run on, 0 for all cores.
+     */
+    explicit stai_mpu_scheduler(uint64_t cpu_affinity_mask = 0) : sequence_(0), exit_(false) {
+        worker_ = std::thread([this, cpu_affinity_mask]() {
+            stai_mpu_set_cpu_affinity(cpu_affinity_mask);
+            loop();
+        });
+    }
+
+    /**
+     * @brief Stops the thread once the running job is done, the queued jobs being cancelled.
+     */
+    ~stai_mpu_scheduler() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            exit_ = true;
+        }
+        cond_.notify_all();
+        worker_.join();
+    }
+
+    stai_mpu_scheduler(const stai_mpu_scheduler&) = delete;
+    stai_mpu_scheduler& operator=(const stai_mpu_scheduler&) = delete;
+
+    /**
+     * @brief Queues a job.
+     *
+     * @param job The job, returning false on failure. An exception thrown by the job is \
+     * forwarded to the future.
+     * @param priority The priority of the job, higher values running first.
+     * @param deadline The time after which the job is dropped if it has not started.
+     * @return The future status of the job.
+     */
+    std::future<stai_mpu_job_status> submit(std::function<bool()> job, int priority = 0,
+                                            clock::time_point deadline = clock::time_point::max()) {
+        entry queued;
+        queued.job = std::move(job);
+        queued.priority = priority;
+        queued.deadline = deadline;
+        queued.submit_ns = stai_mpu_now_ns();
+        queued.promise = std::make_shared<std::promise<stai_mpu_job_status>>();
+        std::future<stai_mpu_job_status> result = queued.promise->get_future();
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            queued.sequence = sequence_++;
+            if (exit_) {
+                queued.promise->set_value(stai_mpu_job_status::STAI_MPU_JOB_CANCELLED);
+                return result;
+            }
+            queue_.push(std::move(queued));
+        }
+        cond_.notify_one();
+        return result;
+    }
+
+    /**
+     * @brief Queues an inference of a network on the inputs already set.
+     *
+     * @param network The network to run.
+     * @param priority The priority of the job, higher values running first.
+     * @param deadline The time after which the job is dropped if it has not started.
+     * @return The future status of the job.
+     */
+    std::future<stai_mpu_job_status> submit(stai_mpu_network& network, int priority = 0,
+                                            clock::time_point deadline = clock::time_point::max()) {
+        return submit([&network]() { return network.run(); }, priority, deadline);
+    }
+
+    /**
+     * @brief Queues a job and waits for it to be done.
+     *
+     * @return The status of the job.
+     */
+    stai_mpu_job_status run(std::function<bool()> job, int priority = 0,
+                            clock::time_point deadline = clock::time_point::max()) {
+        return submit(std::move(job), priority, deadline).get();
+    }
+
+    /**
+     * @brief Gets the number of jobs waiting in the queue.
+     */
+    size_t get_queue_size() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return queue_.size();
+    }
+
+    /**
+     * @brief Gets the statistics of the time the jobs waited in the queue before running.
+     */
+    stai_mpu_stats get_wait_stats() const {
+        return wait_hist_.get_stats();
+    }
+
+    /**
+     * @brief Gets the statistics of the execution time of the jobs.
+     */
+    stai_mpu_stats get_run_stats() const {
+        return run_hist_.get_stats();
+    }
+
+private:
+    struct entry {
+        std::function<bool()> job;
+        int priority;
+        clock::time_point deadline;
+        uint64_t sequence;
+        uint64_t submit_ns;
+        std::shared_ptr<std::promise<stai_mpu_job_status>> promise;
+    };
+
+    /* Orders the heap so that its top is the job to run next */
+    struct later {
+        bool operator()(const entry& a, const entry& b) const {
+            if (a.priority != b.priority)
+                return a.priority < b.priority;
+            if (a.deadline != b.deadline)
+                return a.deadline > b.deadline;
+            return a.sequence > b.sequence;
+        }
+    };
+
+    void loop() {
+        while (true) {
+            entry next;
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                cond_.wait(lock, [this]() { return exit_ || !queue_.empty(); });
+                if (exit_) {
+                    while (!queue_.empty()) {
+                        queue_.top().promise->set_value(stai_mpu_job_status::STAI_MPU_JOB_CANCELLED);
+                        queue_.pop();
+                    }
+                    return;
+                }
+                next = queue_.top();
+                queue_.pop();
+            }
+            if (clock::now() > next.deadline) {
+                next.promise->set_value(stai_mpu_job_status::STAI_MPU_JOB_EXPIRED);
+                continue;
+            }
+            uint64_t start_ns = wait_hist_.record_since(next.submit_ns) + next.submit_ns;
+            try {
+                bool done = next.job();
+                run_hist_.record_since(start_ns);
+                next.promise->set_value(done ? stai_mpu_job_status::STAI_MPU_JOB_DONE
+                                             : stai_mpu_job_status::STAI_MPU_JOB_FAILED);
+            } catch (...) {
+                run_hist_.record_since(start_ns);
+                next.promise->set_exception(std::current_exception());
+            }
+        }
+    }
+
+    std::priority_queue<entry, std::vector<entry>, later> queue_;
+    std::mutex mutex_;
+    std::condition_variable cond_;
+    uint64_t sequence_;
+    bool exit_;
+    stai_mpu_latency_histogram wait_hist_;
+    stai_mpu_latency_histogram run_hist_;
+    std::thread worker_;
+};
+
+#endif //STAI_MPU_SCHEDULER_H_
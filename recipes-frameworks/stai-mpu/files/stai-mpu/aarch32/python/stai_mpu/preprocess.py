@@ -0,0 +1,60 @@
+""" Conversion of uint8 HWC frames into the exact input of a model.
+
+The pixels are normalized as real = (pixel - mean) / std, converted to the
+input data type (float32, float16, or affine quantized integers) and laid out
+as NHWC or NCHW in a single pass. The conversion of the 256 possible pixel
+values is computed once per channel into a lookup table, so converting a frame
+is a single vectorized gather, without the float temporaries of the numpy
+normalization expression.
+"""
+
+from typing import Optional, Sequence, Union
+from numpy.typing import NDArray, DTypeLike
+import numpy as np
+from . import quant
+
+
+class Preprocessor:
+    """Converts uint8 HWC frames into the input data of a model."""
+
+    def __init__(self, mean: Union[float, Sequence[float]], std: Union[float, Sequence[float]],
+                 dtype: DTypeLike = np.float32, layout: str = "NHWC",
+                 scale: Optional[float] = None, zero_point: int = 0) -> None:
+        """
+        :param mean: mean subtracted from the pixels, one value or one per channel
+        :param std: standard deviation the pixels are divided by, one value or one per channel
+        :param dtype: data type of the model input
+        :param layout: "NHWC" or "NCHW" layout of the model input
+        :param scale: affine quantization scale of integer model inputs
+        :param zero_point: affine quantization zero point of integer model inputs
+        """
+        if layout not in ("NHWC", "NCHW"):
+            raise ValueError("Unsupported layout " + layout)
+        self._layout = layout
+        self._dtype = np.dtype(dtype)
+        mean = np.atleast_1d(np.asarray(mean, dtype=np.float32))
+        std = np.atleast_1d(np.asarray(std, dtype=np.float32))
+        with np.errstate(divide="ignore", invalid="ignore"):
+            real = (np.arange(256, dtype=np.float32)[np.newaxis, :] - mean[:, np.newaxis]) / std[:, np.newaxis]
+        if np.issubdtype(self._dtype, np.floating):
+            self._lut = real.astype(self._dtype)
+        else:
+            if scale is None:
+                raise ValueError("Integer model inputs need their quantization scale")
+            self._lut = quant.quantize(real, scale, zero_point, self._dtype)
+
+    def __call__(self, frame: NDArray, out: Optional[NDArray] = None) -> NDArray:
+        """Converts a uint8 frame of shape (H, W, C) or (N, H, W, C) into the model input."""
+        channels = frame.shape[-1]
+        if out is None:
+            shape = frame.shape
+            if self._layout == "NCHW":
+                shape = shape[:-3] + (channels,) + shape[-3:-1]
+            out = np.empty(shape, dtype=self._dtype)
+        if self._layout == "NHWC" and self._lut.shape[0] == 1:
+            return np.take(self._lut[0], frame, out=out, mode="clip")
+        for c in range(channels):
+            lut = self._lut[c if self._lut.shape[0] > 1 else 0]
+            dst = out[..., c] if self._layout == "NHWC" else out[..., c, :, :]
+            np.take(lut, frame[..., c], out=dst, mode="clip")
+        return out
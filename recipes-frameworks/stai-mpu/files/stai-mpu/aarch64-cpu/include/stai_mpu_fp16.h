@@ -0,0 +1,148 @@
+/*
+ * Copyright (c) 2024 STMicroelectronics.
+ * All rights reserved.
+ *
+ * This software is licensed under terms that can be found in the LICENSE file
+ * in the root directory of this software component.
+ * If no LICENSE file comes with this software, it is provided AS-IS.
+ *
+ */
+
+#ifndef STAI_MPU_FP16_H_
+#define STAI_MPU_FP16_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__aarch64__) || ((defined(__ARM_NEON) || defined(__ARM_NEON__)) && defined(__ARM_FP) && (__ARM_FP & 2))
+#include <arm_neon.h>
+#define STAI_MPU_FP16_NEON 1
+#elif defined(__F16C__)
+#include <immintrin.h>
+#define STAI_MPU_FP16_F16C 1
+#endif
+
+/*
+ * Bulk IEEE 754 half <-> single precision conversions, rounding to the nearest, ties to even,
+ * and keeping the infinities, NaNs and denormals. The conversions use the half precision
+ * conversion instructions of the target when available (NEON on aarch64 and on armv7 with
+ * the fp16 extension, F16C on x86) and a branch light bit manipulation fallback elsewhere.
+ */
+
+/**
+ * @brief Converts one half precision value to single precision.
+ *
+ * @param half The half precision value.
+ * @return The single precision value.
+ */
+inline float stai_mpu_half_to_float(uint16_t half) {
+    const uint32_t shifted_exp = 0x7c00u << 13;
+    uint32_t bits = (uint32_t)(half & 0x7fff) << 13;
+    uint32_t exp = bits & shifted_exp;
+    bits += (127 - 15) << 23;
+    if (exp == shifted_exp) {
+        /* Infinity or NaN */
+        bits += (128 - 16) << 23;
+    } else if (exp == 0) {
+        /* Zero or denormal, renormalized by the FPU */
+        const uint32_t magic_bits = 113u << 23;
+        float magic, value;
+        bits += 1u << 23;
+        std::memcpy(&magic, &magic_bits, sizeof(magic));
+        std::memcpy(&value, &bits, sizeof(value));
+        value -= magic;
+        std::memcpy(&bits, &value, sizeof(bits));
+    }
+    bits |= (uint32_t)(half & 0x8000) << 16;
+    float result;
+    std::memcpy(&result, &bits, sizeof(result));
+    return result;
+}
+
+/**
+ * @brief Converts one single precision value to half precision.
+ *
+ * @param value The single precision value.
+ * @return The half precision value.
+ */
+inline uint16_t stai_mpu_float_to_half(float value) {
+    const uint32_t f32_infinity = 255u << 23;
+    const uint32_t f16_max = (127u + 16) << 23;
+    const uint32_t denorm_magic_bits = ((127u - 15) + (23 - 10) + 1) << 23;
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    uint32_t sign = bits & 0x80000000u;
+    bits ^= sign;
+    uint16_t half;
+    if (bits >= f16_max) {
+        /* Overflow to infinity, NaN kept as a quiet NaN */
+        half = bits > f32_infinity ? 0x7e00 : 0x7c00;
+    } else if (bits < (113u << 23)) {
+        /* Denormal or zero, rounded by the FPU */
+        float denorm_magic, abs_value;
+        std::memcpy(&denorm_magic, &denorm_magic_bits, sizeof(denorm_magic));
+        std::memcpy(&abs_value, &bits, sizeof(abs_value));
+        abs_value += denorm_magic;
+        std::memcpy(&bits, &abs_value, sizeof(bits));
+        half = (uint16_t)(bits - denorm_magic_bits);
+    } else {
+        uint32_t mantissa_odd = (bits >> 13) & 1;
+        bits += ((uint32_t)(15 - 127) << 23) + 0xfff;
+        bits += mantissa_odd;
+        half = (uint16_t)(bits >> 13);
+    }
+    return half | (uint16_t)(sign >> 16);
+}
+
+/**
+ * @brief Converts an array of half precision values to single precision.
+ *
+ * @param in The half precision values.
+ * @param out The single precision values.
+ * @param count The number of values.
+ */
+inline void stai_mpu_fp16_to_fp32_array(const uint16_t* in, float* out, size_t count) {
+    size_t i = 0;
+#if defined(STAI_MPU_FP16_NEON)
+    for (; i + 8 <= count; i += 8) {
+        uint16x8_t half = vld1q_u16(in + i);
+        vst1q_f32(out + i, vcvt_f32_f16(vreinterpret_f16_u16(vget_low_u16(half))));
+        vst1q_f32(out + i + 4, vcvt_f32_f16(vreinterpret_f16_u16(vget_high_u16(half))));
+    }
+#elif defined(STAI_MPU_FP16_F16C)
+    for (; i + 8 <= count; i += 8) {
+        __m128i half = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+        _mm256_storeu_ps(out + i, _mm256_cvtph_ps(half));
+    }
+#endif
+    for (; i < count; i++)
+        out[i] = stai_mpu_half_to_float(in[i]);
+}
+
+/**
+ * @brief Converts an array of single precision values to half precision.
+ *
+ * @param in The single precision values.
+ * @param out The half precision values.
+ * @param count The number of values.
+ */
+inline void stai_mpu_fp32_to_fp16_array(const float* in, uint16_t* out, size_t count) {
+    size_t i = 0;
+#if defined(STAI_MPU_FP16_NEON)
+    for (; i + 8 <= count; i += 8) {
+        float16x4_t low = vcvt_f16_f32(vld1q_f32(in + i));
+        float16x4_t high = vcvt_f16_f32(vld1q_f32(in + i + 4));
+        vst1q_u16(out + i, vcombine_u16(vreinterpret_u16_f16(low), vreinterpret_u16_f16(high)));
+    }
+#elif defined(STAI_MPU_FP16_F16C)
+    for (; i + 8 <= count; i += 8) {
+        __m128i half = _mm256_cvtps_ph(_mm256_loadu_ps(in + i), _MM_FROUND_TO_NEAREST_INT);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), half);
+    }
+#endif
+    for (; i < count; i++)
+        out[i] = stai_mpu_float_to_half(in[i]);
+}
+
+#endif //STAI_MPU_FP16_H_
@@ -12,16 +12,75 @@
 #define STAI_MPU_NETWORK_H_
 
 
+#include <algorithm>
 #include <memory>
 #include <string>
 #include <vector>
 #include <stdexcept>
+#include <cstdint>
+#include <sched.h>
 
 #ifndef STAI_MPU_VERSION_MAJOR
 #define STAI_MPU_VERSION_MAJOR "6"
 #endif
 
 #include "stai_mpu_wrapper.h"
+#include "stai_mpu_stats.h"
+
+/**
+ * @brief Runtime options of a @ref stai_mpu_network "stai_mpu_network". The prebuilt backend \
+ * plugins use their built-in thread count and graph settings, which cannot be changed from here.
+ */
+struct stai_mpu_network_options {
+    /** Mask of the CPU cores the inference threads may run on, bit N for core N, 0 for all cores. */
+    uint64_t cpu_affinity_mask = 0;
+    /** Number of inferences run on zeroed inputs at load time, 0 to disable the warm-up. */
+    int warmup_iterations = 0;
+    /** If not null, filled at load time with the load and warm-up timings. */
+    stai_mpu_startup_stats* startup_stats = nullptr;
+};
+
+/**
+ * @brief Restricts the calling thread to the CPU cores of a mask.
+ *
+ * @param mask The mask of the CPU cores, bit N for core N. A null mask leaves the affinity untouched.
+ * @return True if the affinity was changed, false otherwise.
+ */
+inline bool stai_mpu_set_cpu_affinity(uint64_t mask) {
+    if (mask == 0)
+        return false;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (int cpu = 0; cpu < 64; cpu++) {
+        if (mask & (1ULL << cpu))
+            CPU_SET(cpu, &set);
+    }
+    return sched_setaffinity(0, sizeof(set), &set) == 0;
+}
+
+/**
+ * @brief Restricts the calling thread to the CPU cores of a mask for the lifetime of the object, \
+ * the threads it creates in the meantime inheriting the restriction.
+ */
+class stai_mpu_cpu_affinity_scope {
+public:
+    explicit stai_mpu_cpu_affinity_scope(uint64_t mask) : restore_(false) {
+        if (mask != 0 && sched_getaffinity(0, sizeof(saved_), &saved_) == 0)
+            restore_ = stai_mpu_set_cpu_affinity(mask);
+    }
+
+    ~stai_mpu_cpu_affinity_scope() {
+        if (restore_)
+            sched_setaffinity(0, sizeof(saved_), &saved_);
+    }
+
+    stai_mpu_cpu_affinity_scope(const stai_mpu_cpu_affinity_scope&) = delete;
+    stai_mpu_cpu_affinity_scope& operator=(const stai_mpu_cpu_affinity_scope&) = delete;
+
+private:
+    cpu_set_t saved_;
+    bool restore_;
+};
 
 /**
  * @brief A class that wraps Unified model inference functionality. \
@@ -40,6 +99,22 @@ public:
      */
     stai_mpu_network(const std::string& model_path, bool use_hw_acceleration);
 
+    /**
+     * @brief Constructor for the stai_mpu_network class with runtime options. The backend plugin is \
+     * loaded with the calling thread restricted to the CPU affinity mask of the options, so that \
+     * the threads created by the backend at load time inherit it. The affinity of the calling \
+     * thread is restored afterwards, after the optional warm-up.
+     *
+     * @param model_path The path to the TFLite/Onnx/Nbg model file.
+     * @param use_hw_acceleration Enable HW acceleration if available for the TFLite/Onnx/Nbg model.
+     * @param options The runtime options.
+     */
+    stai_mpu_network(const std::string& model_path, bool use_hw_acceleration,
+                     const stai_mpu_network_options& options)
+        : stai_mpu_network(model_path, use_hw_acceleration, options, stai_mpu_now_ns(),
+                           stai_mpu_cpu_affinity_scope(options.cpu_affinity_mask)) {}
+
+
     /**
      * @brief Constructor for the stai_mpu_network class without arguments.
      */
@@ -120,7 +195,65 @@ public:
      */
     virtual stai_mpu_backend_engine get_backend_engine();
 
+    /**
+     * @brief Runs inferences on zeroed inputs, so that the initializations the backends defer to \
+     * the first run (delegate compilation, arena allocations) do not stall the first real \
+     * inference. The inputs have to be set again afterwards.
+     *
+     * @param iterations The number of inferences to run.
+     * @return The timings of the warm-up runs, load_ms being left to 0.
+     * @throws std::runtime_error If an inference fails.
+     */
+    stai_mpu_startup_stats warmup(int iterations) {
+        stai_mpu_startup_stats stats;
+        if (iterations <= 0)
+            return stats;
+        std::vector<stai_mpu_tensor> input_infos = get_input_infos();
+        size_t max_bytes = 0;
+        for (const stai_mpu_tensor& info : input_infos) {
+            size_t bytes = info.get_size_in_bytes();
+            /* The OVX backend reads the half precision inputs as float32 */
+            stai_mpu_dtype dtype = info.get_dtype();
+            if (dtype == stai_mpu_dtype::STAI_MPU_DTYPE_FLOAT16 || dtype == stai_mpu_dtype::STAI_MPU_DTYPE_BFLOAT16)
+                bytes = std::max(bytes, info.get_num_elements() * sizeof(float));
+            max_bytes = std::max(max_bytes, bytes);
+        }
+        std::vector<uint8_t> zeros(max_bytes, 0);
+        uint64_t total_ns = 0;
+        for (int i = 0; i < iterations; i++) {
+            for (size_t index = 0; index < input_infos.size(); index++)
+                set_input(index, zeros.data());
+            uint64_t start_ns = stai_mpu_now_ns();
+            if (!run())
+                throw std::runtime_error("[WARMUP] Inference failed during the warm-up");
+            uint64_t duration_ns = stai_mpu_now_ns() - start_ns;
+            if (i == 0)
+                stats.first_run_ms = duration_ns / 1e6;
+            else
+                total_ns += duration_ns;
+        }
+        stats.warmup_runs = iterations;
+        if (iterations > 1)
+            stats.warmup_mean_ms = total_ns / 1e6 / (iterations - 1);
+        return stats;
+    }
+
 private:
+    /* The affinity scope is a temporary of the delegating call, so it spans both the load and
+     * the warm-up. The load time is counted from load_start_ns. */
+    stai_mpu_network(const std::string& model_path, bool use_hw_acceleration,
+                     const stai_mpu_network_options& options, uint64_t load_start_ns,
+                     const stai_mpu_cpu_affinity_scope& /*affinity_scope*/)
+        : stai_mpu_network(model_path, use_hw_acceleration) {
+        uint64_t loaded_ns = stai_mpu_now_ns();
+        stai_mpu_startup_stats stats;
+        if (options.warmup_iterations > 0)
+            stats = warmup(options.warmup_iterations);
+        stats.load_ms = (loaded_ns - load_start_ns) / 1e6;
+        if (options.startup_stats)
+            *options.startup_stats = stats;
+    }
+
     stai_mpu_wrapper* stai_mpu_wrapper_;
     std::string library_path_;
     void *lib_handle_;
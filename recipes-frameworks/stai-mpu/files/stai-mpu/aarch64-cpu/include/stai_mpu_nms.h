@@ -0,0 +1,294 @@
+/*
+ * Copyright (c) 2024 STMicroelectronics.
+ * All rights reserved.
+ *
+ * This software is licensed under terms that can be found in the LICENSE file
+ * in the root directory of this software component.
+ * If no LICENSE file comes with this software, it is provided AS-IS.
+ *
+ */
+
+#ifndef STAI_MPU_NMS_H_
+#define STAI_MPU_NMS_H_
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define STAI_MPU_NMS_NEON 1
+#endif
+
+/*
+ * Non maximum suppression of detection boxes given as (x0, y0, x1, y1) corners. The boxes are
+ * stored as a structure of arrays so that the overlaps of a kept box with all the remaining
+ * ones are computed 4 at a time with NEON. The overlap test of the hard suppression is done
+ * as intersection > threshold * union, without division. Degenerate boxes never overlap.
+ */
+
+/**
+ * @brief Suppression applied by a @ref stai_mpu_nms "stai_mpu_nms" to the boxes overlapping a kept box.
+ */
+enum class stai_mpu_nms_method {
+    /** Overlapping boxes are removed. */
+    STAI_MPU_NMS_HARD,
+    /** Overlapping boxes have their score multiplied by (1 - IoU). */
+    STAI_MPU_NMS_SOFT_LINEAR,
+    /** All the boxes have their score multiplied by exp(-IoU^2 / sigma). */
+    STAI_MPU_NMS_SOFT_GAUSSIAN
+};
+
+/**
+ * @brief Parameters of a @ref stai_mpu_nms "stai_mpu_nms" run.
+ */
+struct stai_mpu_nms_params {
+    /** IoU above which two boxes overlap. */
+    float iou_threshold = 0.5f;
+    /** Score under which a box is discarded, before the suppression and, for the soft methods, after its decay. */
+    float score_threshold = 0.0f;
+    /** Number of best scored boxes entering the suppression, 0 for all. */
+    size_t top_k = 0;
+    /** Maximum number of kept boxes, 0 for no limit. */
+    size_t max_output = 0;
+    /** Only boxes of the same class suppress each other. */
+    bool class_aware = true;
+    /** Suppression method. */
+    stai_mpu_nms_method method = stai_mpu_nms_method::STAI_MPU_NMS_HARD;
+    /** Sigma of the gaussian soft suppression. */
+    float sigma = 0.5f;
+};
+
+/**
+ * @brief A reusable non maximum suppression engine. The boxes are added one by one, then run() \
+ * returns the indexes of the kept boxes by decreasing score. No allocation happens once the \
+ * engine has been reserved for the maximum number of boxes.
+ */
+class stai_mpu_nms {
+public:
+    /**
+     * @brief Creates the engine.
+     *
+     * @param capacity The number of boxes to reserve room for.
+     */
+    explicit stai_mpu_nms(size_t capacity = 0) {
+        reserve(capacity);
+    }
+
+    /**
+     * @brief Reserves room for a number of boxes.
+     */
+    void reserve(size_t capacity) {
+        for (std::vector<float>* array : {&x0_, &y0_, &x1_, &y1_, &scores_, &final_scores_,
+                                          &w_x0_, &w_y0_, &w_x1_, &w_y1_, &w_area_, &w_score_})
+            array->reserve(capacity);
+        classes_.reserve(capacity);
+        w_class_.reserve(capacity);
+        order_.reserve(capacity);
+        w_suppressed_.reserve(capacity);
+    }
+
+    /**
+     * @brief Removes all the boxes, keeping the reserved room.
+     */
+    void clear() {
+        x0_.clear();
+        y0_.clear();
+        x1_.clear();
+        y1_.clear();
+        scores_.clear();
+        classes_.clear();
+    }
+
+    /**
+     * @brief Adds a box.
+     *
+     * @return The index of the box.
+     */
+    uint32_t add(float x0, float y0, float x1, float y1, float score, int32_t class_id = 0) {
+        x0_.push_back(x0);
+        y0_.push_back(y0);
+        x1_.push_back(x1);
+        y1_.push_back(y1);
+        scores_.push_back(score);
+        classes_.push_back(class_id);
+        return (uint32_t)(scores_.size() - 1);
+    }
+
+    /**
+     * @brief Gets the number of boxes added.
+     */
+    size_t size() const {
+        return scores_.size();
+    }
+
+    /**
+     * @brief Gets the score of a box after the last run, decayed when the method is a soft one.
+     */
+    float get_score(uint32_t index) const {
+        return final_scores_[index];
+    }
+
+    /**
+     * @brief Suppresses the overlapping boxes.
+     *
+     * @param params The parameters of the suppression.
+     * @param keep The indexes of the kept boxes by decreasing score, room for min(size(), \
+     * params.top_k, params.max_output) indexes being needed.
+     * @return The number of kept boxes.
+     */
+    size_t run(const stai_mpu_nms_params& params, uint32_t* keep) {
+        size_t count = select(params);
+        if (params.method == stai_mpu_nms_method::STAI_MPU_NMS_HARD)
+            return run_hard(params, count, keep);
+        return run_soft(params, count, keep);
+    }
+
+private:
+    /* Sorts the indexes of the boxes above the score threshold, keeping the top_k best ones,
+     * and gathers these boxes in the working arrays */
+    size_t select(const stai_mpu_nms_params& params) {
+        final_scores_.assign(scores_.begin(), scores_.end());
+        order_.clear();
+        for (uint32_t i = 0; i < (uint32_t)scores_.size(); i++) {
+            if (scores_[i] >= params.score_threshold)
+                order_.push_back(i);
+        }
+        auto better = [this](uint32_t a, uint32_t b) {
+            return scores_[a] > scores_[b] || (scores_[a] == scores_[b] && a < b);
+        };
+        size_t count = order_.size();
+        if (params.top_k != 0 && params.top_k < count) {
+            std::partial_sort(order_.begin(), order_.begin() + params.top_k, order_.end(), better);
+            count = params.top_k;
+            order_.resize(count);
+        } else {
+            std::sort(order_.begin(), order_.end(), better);
+        }
+
+        w_x0_.resize(count);
+        w_y0_.resize(count);
+        w_x1_.resize(count);
+        w_y1_.resize(count);
+        w_area_.resize(count);
+        w_score_.resize(count);
+        w_class_.resize(count);
+        for (size_t k = 0; k < count; k++) {
+            uint32_t i = order_[k];
+            w_x0_[k] = x0_[i];
+            w_y0_[k] = y0_[i];
+            w_x1_[k] = x1_[i];
+            w_y1_[k] = y1_[i];
+            w_area_[k] = std::max(0.0f, x1_[i] - x0_[i]) * std::max(0.0f, y1_[i] - y0_[i]);
+            w_score_[k] = scores_[i];
+            /* Class agnostic suppression puts all the boxes in the same class */
+            w_class_[k] = params.class_aware ? classes_[i] : 0;
+        }
+        return count;
+    }
+
+    /* Marks the boxes of [begin, count) of the class of box k overlapping it */
+    void suppress_overlaps(size_t k, size_t begin, size_t count, float iou_threshold) {
+        uint32_t* suppressed = w_suppressed_.data();
+        const float kx0 = w_x0_[k], ky0 = w_y0_[k], kx1 = w_x1_[k], ky1 = w_y1_[k];
+        const float karea = w_area_[k];
+        const int32_t kclass = w_class_[k];
+        size_t j = begin;
+#ifdef STAI_MPU_NMS_NEON
+        const float32x4_t vx0 = vdupq_n_f32(kx0), vy0 = vdupq_n_f32(ky0);
+        const float32x4_t vx1 = vdupq_n_f32(kx1), vy1 = vdupq_n_f32(ky1);
+        const float32x4_t varea = vdupq_n_f32(karea), vthreshold = vdupq_n_f32(iou_threshold);
+        const float32x4_t zero = vdupq_n_f32(0.0f);
+        const int32x4_t vclass = vdupq_n_s32(kclass);
+        for (; j + 4 <= count; j += 4) {
+            float32x4_t w = vsubq_f32(vminq_f32(vx1, vld1q_f32(&w_x1_[j])), vmaxq_f32(vx0, vld1q_f32(&w_x0_[j])));
+            float32x4_t h = vsubq_f32(vminq_f32(vy1, vld1q_f32(&w_y1_[j])), vmaxq_f32(vy0, vld1q_f32(&w_y0_[j])));
+            float32x4_t inter = vmulq_f32(vmaxq_f32(w, zero), vmaxq_f32(h, zero));
+            float32x4_t uni = vsubq_f32(vaddq_f32(varea, vld1q_f32(&w_area_[j])), inter);
+            uint32x4_t overlap = vcgtq_f32(inter, vmulq_f32(vthreshold, uni));
+            overlap = vandq_u32(overlap, vceqq_s32(vclass, vld1q_s32(&w_class_[j])));
+            vst1q_u32(suppressed + j, vorrq_u32(vld1q_u32(suppressed + j), overlap));
+        }
+#endif
+        for (; j < count; j++) {
+            float w = std::max(0.0f, std::min(kx1, w_x1_[j]) - std::max(kx0, w_x0_[j]));
+            float h = std::max(0.0f, std::min(ky1, w_y1_[j]) - std::max(ky0, w_y0_[j]));
+            float inter = w * h;
+            float uni = karea + w_area_[j] - inter;
+            if (inter > iou_threshold * uni && w_class_[j] == kclass)
+                suppressed[j] = ~0u;
+        }
+    }
+
+    size_t run_hard(const stai_mpu_nms_params& params, size_t count, uint32_t* keep) {
+        w_suppressed_.assign(count, 0);
+        size_t kept = 0;
+        for (size_t k = 0; k < count; k++) {
+            if (w_suppressed_[k])
+                continue;
+            keep[kept++] = order_[k];
+            if (kept == params.max_output)
+                break;
+            suppress_overlaps(k, k + 1, count, params.iou_threshold);
+        }
+        return kept;
+    }
+
+    /* The scores decay, so the best remaining box is searched at each step and swapped in front */
+    size_t run_soft(const stai_mpu_nms_params& params, size_t count, uint32_t* keep) {
+        const bool gaussian = params.method == stai_mpu_nms_method::STAI_MPU_NMS_SOFT_GAUSSIAN;
+        const float inv_sigma = 1.0f / params.sigma;
+        size_t kept = 0;
+        for (size_t k = 0; k < count; k++) {
+            size_t best = std::max_element(w_score_.begin() + k, w_score_.begin() + count) - w_score_.begin();
+            if (w_score_[best] < params.score_threshold)
+                break;
+            if (best != k) {
+                std::swap(w_x0_[k], w_x0_[best]);
+                std::swap(w_y0_[k], w_y0_[best]);
+                std::swap(w_x1_[k], w_x1_[best]);
+                std::swap(w_y1_[k], w_y1_[best]);
+                std::swap(w_area_[k], w_area_[best]);
+                std::swap(w_score_[k], w_score_[best]);
+                std::swap(w_class_[k], w_class_[best]);
+                std::swap(order_[k], order_[best]);
+            }
+            final_scores_[order_[k]] = w_score_[k];
+            keep[kept++] = order_[k];
+            if (kept == params.max_output)
+                break;
+            for (size_t j = k + 1; j < count; j++) {
+                if (w_class_[j] != w_class_[k])
+                    continue;
+                float w = std::max(0.0f, std::min(w_x1_[k], w_x1_[j]) - std::max(w_x0_[k], w_x0_[j]));
+                float h = std::max(0.0f, std::min(w_y1_[k], w_y1_[j]) - std::max(w_y0_[k], w_y0_[j]));
+                float inter = w * h;
+                float uni = w_area_[k] + w_area_[j] - inter;
+                float iou = uni > 0.0f ? inter / uni : 0.0f;
+                if (gaussian)
+                    w_score_[j] *= std::exp(-iou * iou * inv_sigma);
+                else if (iou > params.iou_threshold)
+                    w_score_[j] *= 1.0f - iou;
+            }
+        }
+        /* The boxes left out have their decayed score too */
+        for (size_t k = kept; k < count; k++)
+            final_scores_[order_[k]] = w_score_[k];
+        return kept;
+    }
+
+    /* Boxes as added */
+    std::vector<float> x0_, y0_, x1_, y1_, scores_;
+    std::vector<int32_t> classes_;
+    /* Scores after the last run */
+    std::vector<float> final_scores_;
+    /* Working arrays of the selected boxes, by decreasing score */
+    std::vector<uint32_t> order_;
+    std::vector<float> w_x0_, w_y0_, w_x1_, w_y1_, w_area_, w_score_;
+    std::vector<int32_t> w_class_;
+    std::vector<uint32_t> w_suppressed_;
+};
+
+#endif //STAI_MPU_NMS_H_
@@ -0,0 +1,289 @@
+/*
+ * Copyright (c) 2024 STMicroelectronics.
+ * All rights reserved.
+ *
+ * This software is licensed under terms that can be found in the LICENSE file
+ * in the root directory of this software component.
+ * If no LICENSE file comes with this software, it is provided AS-IS.
+ *
+ */
+
+#ifndef STAI_MPU_RUNNER_H_
+#define STAI_MPU_RUNNER_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "stai_mpu_network.h"
+#include "stai_mpu_stats.h"
+
+/**
+ * @brief Gets the size of the data exchanged with a backend for a tensor. The OVX backend \
+ * converts the half precision tensors from and to float32, so that their data is 4 bytes per \
+ * element.
+ *
+ * @param info The information of the tensor.
+ * @param backend The backend engine running the model.
+ * @return The size in bytes of the data given to set_input() or returned by get_output().
+ */
+inline size_t stai_mpu_runtime_size_in_bytes(const stai_mpu_tensor& info, stai_mpu_backend_engine backend) {
+    stai_mpu_dtype dtype = info.get_dtype();
+    if (backend == stai_mpu_backend_engine::STAI_MPU_OVX_NPU_ENGINE &&
+        (dtype == stai_mpu_dtype::STAI_MPU_DTYPE_FLOAT16 || dtype == stai_mpu_dtype::STAI_MPU_DTYPE_BFLOAT16))
+        return info.get_num_elements() * sizeof(float);
+    return info.get_size_in_bytes();
+}
+
+/**
+ * @brief Runs a loaded @ref stai_mpu_network "stai_mpu_network" for an application. The runner \
+ * binds caller owned buffers to the inputs, hands out borrowed views on the outputs, queues \
+ * inferences on a worker thread and records the latency of the set_input, run and get_output \
+ * phases. The network must outlive the runner.
+ *
+ * The OVX backend returns each output in a heap buffer allocated by the plugin, which the \
+ * runner keeps as the view and frees on the next view of the same output. The other backends \
+ * return a pointer into their own output tensor.
+ */
+class stai_mpu_runner {
+public:
+    /**
+     * @brief Constructor for the stai_mpu_runner class.
+     *
+     * @param network The network to run.
+     * @param startup_stats The load and warm-up timings of the network, reported by get_stats().
+     * @param cpu_affinity_mask The mask of the CPU cores the worker thread may run on, 0 for all cores.
+     */
+    explicit stai_mpu_runner(stai_mpu_network& network,
+                             const stai_mpu_startup_stats& startup_stats = stai_mpu_startup_stats(),
+                             uint64_t cpu_affinity_mask = 0)
+        : network_(network), backend_(network.get_backend_engine()), startup_stats_(startup_stats),
+          cpu_affinity_mask_(cpu_affinity_mask), last_run_ms_(0), worker_exit_(false) {
+        for (const stai_mpu_tensor& info : network.get_input_infos())
+            input_bytes_.push_back(stai_mpu_runtime_size_in_bytes(info, backend_));
+        for (const stai_mpu_tensor& info : network.get_output_infos())
+            output_bytes_.push_back(stai_mpu_runtime_size_in_bytes(info, backend_));
+        plugin_outputs_.resize(output_bytes_.size(), nullptr);
+    }
+
+    stai_mpu_runner(const stai_mpu_runner&) = delete;
+    stai_mpu_runner& operator=(const stai_mpu_runner&) = delete;
+
+    /**
+     * @brief Destructor for the stai_mpu_runner class. The inferences already queued are run \
+     * before the worker thread exits.
+     */
+    ~stai_mpu_runner() {
+        {
+            std::lock_guard<std::mutex> lock(worker_mutex_);
+            worker_exit_ = true;
+        }
+        worker_cond_.notify_all();
+        if (worker_.joinable())
+            worker_.join();
+        for (void* output : plugin_outputs_)
+            free(output);
+    }
+
+    /**
+     * @brief Retrieves the backend engine running the network.
+     */
+    stai_mpu_backend_engine get_backend_engine() const { return backend_; }
+
+    /**
+     * @brief Gets the size of the data of an input, as given to bind_input().
+     */
+    size_t get_input_size_in_bytes(int index) const { return input_bytes_.at(index); }
+
+    /**
+     * @brief Gets the size of the data of an output, as returned by get_output_view().
+     */
+    size_t get_output_size_in_bytes(int index) const { return output_bytes_.at(index); }
+
+    /**
+     * @brief Binds a caller owned buffer (e.g. a mapped GstBuffer) to an input. The buffer is \
+     * handed to the backend as is, without any intermediate copy, and must stay valid until run().
+     *
+     * @param index The index of the input.
+     * @param buf The input data, laid out as the runtime expects it.
+     * @param bytes The size of the buffer, at least get_input_size_in_bytes(index).
+     */
+    void bind_input(int index, const void* buf, size_t bytes) {
+        if (index < 0 || index >= (int)input_bytes_.size())
+            throw std::runtime_error("[RUNNER] Input index out of bounds");
+        if (bytes < input_bytes_[index])
+            throw std::runtime_error("[RUNNER] Input buffer smaller than the input tensor");
+        uint64_t start_ns = stai_mpu_now_ns();
+        network_.set_input(index, buf);
+        set_input_hist_.record_since(start_ns);
+    }
+
+    /**
+     * @brief Gets a borrowed view on an output, without any copy. The caller must not free it, \
+     * whatever the backend engine is. The view stays valid until the next inference for the \
+     * TFLite and ORT backends, and until the next view of the same output for the OVX backend.
+     *
+     * @param index The index of the output.
+     * @return A pointer to get_output_size_in_bytes(index) bytes of output data.
+     */
+    const void* get_output_view(int index) {
+        if (index < 0 || index >= (int)output_bytes_.size())
+            throw std::runtime_error("[RUNNER] Output index out of bounds");
+        uint64_t start_ns = stai_mpu_now_ns();
+        if (backend_ == stai_mpu_backend_engine::STAI_MPU_OVX_NPU_ENGINE) {
+            free(plugin_outputs_[index]);
+            plugin_outputs_[index] = nullptr;
+        }
+        void* output = network_.get_output(index);
+        if (backend_ == stai_mpu_backend_engine::STAI_MPU_OVX_NPU_ENGINE)
+            plugin_outputs_[index] = output;
+        get_output_hist_.record_since(start_ns);
+        return output;
+    }
+
+    /**
+     * @brief Copies an output into a caller provided buffer.
+     *
+     * @param index The index of the output.
+     * @param dst The destination buffer.
+     * @param bytes The size of the destination buffer, at least get_output_size_in_bytes(index).
+     */
+    void get_output_into(int index, void* dst, size_t bytes) {
+        if (index < 0 || index >= (int)output_bytes_.size())
+            throw std::runtime_error("[RUNNER] Output index out of bounds");
+        if (bytes < output_bytes_[index])
+            throw std::runtime_error("[RUNNER] Output buffer smaller than the output tensor");
+        uint64_t start_ns = stai_mpu_now_ns();
+        void* output = network_.get_output(index);
+        std::memcpy(dst, output, output_bytes_[index]);
+        if (backend_ == stai_mpu_backend_engine::STAI_MPU_OVX_NPU_ENGINE)
+            free(output);
+        get_output_hist_.record_since(start_ns);
+    }
+
+    /**
+     * @brief Runs an inference on the inputs previously bound.
+     *
+     * @return True if the inference succeeded, false otherwise.
+     */
+    bool run() {
+        uint64_t start_ns = stai_mpu_now_ns();
+        bool status = network_.run();
+        last_run_ms_ = run_hist_.record_since(start_ns) / 1e6f;
+        return status;
+    }
+
+    /**
+     * @brief Gets the duration of the last inference.
+     *
+     * @return The duration in milliseconds.
+     */
+    float get_last_run_ms() const { return last_run_ms_; }
+
+    /**
+     * @brief Queues an inference on the worker thread of the runner and returns immediately. \
+     * The inputs must not be changed and the outputs must not be read until the inference is done.
+     *
+     * @param on_done An optional callback, called from the worker thread with the status of \
+     * the inference once it is done.
+     * @return A future holding the status of the inference.
+     */
+    std::future<bool> run_async(std::function<void(bool)> on_done = nullptr) {
+        auto task = std::make_shared<std::packaged_task<bool()>>([this, on_done]() {
+            bool status = run();
+            if (on_done)
+                on_done(status);
+            return status;
+        });
+        std::future<bool> result = task->get_future();
+        {
+            std::lock_guard<std::mutex> lock(worker_mutex_);
+            if (!worker_.joinable())
+                worker_ = std::thread(&stai_mpu_runner::worker_loop, this);
+            worker_jobs_.push([task]() { (*task)(); });
+        }
+        worker_cond_.notify_one();
+        return result;
+    }
+
+    /**
+     * @brief Runs warm-up inferences on zeroed inputs, outside of the latency statistics. The \
+     * startup statistics then report this warm-up, and the inputs have to be bound again.
+     *
+     * @param iterations The number of warm-up inferences.
+     */
+    void warmup(int iterations) {
+        double load_ms = startup_stats_.load_ms;
+        startup_stats_ = network_.warmup(iterations);
+        startup_stats_.load_ms = load_ms;
+    }
+
+    /**
+     * @brief Gets the latency statistics of the set_input, run and get_output phases since the \
+     * creation of the runner or the last call to reset_stats(), along with the startup timings.
+     */
+    stai_mpu_network_stats get_stats() const {
+        stai_mpu_network_stats stats;
+        stats.set_input = set_input_hist_.get_stats();
+        stats.run = run_hist_.get_stats();
+        stats.get_output = get_output_hist_.get_stats();
+        stats.startup = startup_stats_;
+        return stats;
+    }
+
+    /**
+     * @brief Resets the latency statistics.
+     */
+    void reset_stats() {
+        set_input_hist_.reset();
+        run_hist_.reset();
+        get_output_hist_.reset();
+    }
+
+private:
+    /* Worker thread loop running the inferences queued by run_async() */
+    void worker_loop() {
+        stai_mpu_set_cpu_affinity(cpu_affinity_mask_);
+        while (true) {
+            std::function<void()> job;
+            {
+                std::unique_lock<std::mutex> lock(worker_mutex_);
+                worker_cond_.wait(lock, [this]() { return worker_exit_ || !worker_jobs_.empty(); });
+                if (worker_jobs_.empty())
+                    return;
+                job = std::move(worker_jobs_.front());
+                worker_jobs_.pop();
+            }
+            job();
+        }
+    }
+
+    stai_mpu_network& network_;
+    stai_mpu_backend_engine backend_;
+    std::vector<size_t> input_bytes_;
+    std::vector<size_t> output_bytes_;
+    /* Plugin buffers of the OVX views, freed on the next view of the same output */
+    std::vector<void*> plugin_outputs_;
+    stai_mpu_startup_stats startup_stats_;
+    uint64_t cpu_affinity_mask_;
+    std::atomic<float> last_run_ms_;
+    stai_mpu_latency_histogram set_input_hist_;
+    stai_mpu_latency_histogram run_hist_;
+    stai_mpu_latency_histogram get_output_hist_;
+    std::thread worker_;
+    std::mutex worker_mutex_;
+    std::condition_variable worker_cond_;
+    std::queue<std::function<void()>> worker_jobs_;
+    bool worker_exit_;
+};
+
+#endif //STAI_MPU_RUNNER_H_
@@ -0,0 +1,196 @@
+/*
+ * Copyright (c) 2024 STMicroelectronics.
+ * All rights reserved.
+ *
+ * This software is licensed under terms that can be found in the LICENSE file
+ * in the root directory of this software component.
+ * If no LICENSE file comes with this software, it is provided AS-IS.
+ *
+ */
+
+#ifndef STAI_MPU_STATS_H_
+#define STAI_MPU_STATS_H_
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <limits>
+
+/**
+ * @brief Retrieves the current time of the monotonic clock.
+ *
+ * @return The current time in nanoseconds.
+ */
+inline uint64_t stai_mpu_now_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/**
+ * @brief Latency statistics of one phase of the inference. All durations are in milliseconds.
+ */
+struct stai_mpu_stats {
+    uint64_t count = 0;
+    double mean_ms = 0;
+    double min_ms = 0;
+    double max_ms = 0;
+    double p50_ms = 0;
+    double p95_ms = 0;
+    double p99_ms = 0;
+};
+
+/**
+ * @brief Startup timings of a network. All durations are in milliseconds. The load includes the \
+ * plugin loading, the model parsing and the graph verification done by the backends at load time; \
+ * the first run includes the initializations they defer to it (delegate compilation, arena \
+ * allocations).
+ */
+struct stai_mpu_startup_stats {
+    double load_ms = 0;
+    double first_run_ms = 0;
+    /** Number of warm-up runs, including the first one. */
+    uint32_t warmup_runs = 0;
+    /** Mean duration of the warm-up runs following the first one. */
+    double warmup_mean_ms = 0;
+};
+
+/**
+ * @brief Latency statistics of the set_input, run and get_output phases of a network, along \
+ * with its startup timings.
+ */
+struct stai_mpu_network_stats {
+    stai_mpu_stats set_input;
+    stai_mpu_stats run;
+    stai_mpu_stats get_output;
+    stai_mpu_startup_stats startup;
+};
+
+/**
+ * @brief A fixed-size lock-free latency histogram. The samples are stored with a microsecond \
+ * resolution in log-linear buckets, 16 per power of two, so that the percentiles have a relative \
+ * error below 6.25% from 1us up to more than one hour, with a constant memory footprint. \
+ * Recording a sample is wait-free for the count and the sum, and can be done concurrently \
+ * from several threads.
+ */
+class stai_mpu_latency_histogram {
+public:
+    stai_mpu_latency_histogram() { reset(); }
+
+    stai_mpu_latency_histogram(const stai_mpu_latency_histogram&) = delete;
+    stai_mpu_latency_histogram& operator=(const stai_mpu_latency_histogram&) = delete;
+
+    /**
+     * @brief Records a sample.
+     *
+     * @param duration_ns The duration of the sample in nanoseconds.
+     */
+    void record(uint64_t duration_ns) {
+        buckets_[bucket_index(duration_ns / 1000)].fetch_add(1, std::memory_order_relaxed);
+        count_.fetch_add(1, std::memory_order_relaxed);
+        sum_ns_.fetch_add(duration_ns, std::memory_order_relaxed);
+        uint64_t min = min_ns_.load(std::memory_order_relaxed);
+        while (duration_ns < min &&
+               !min_ns_.compare_exchange_weak(min, duration_ns, std::memory_order_relaxed)) {}
+        uint64_t max = max_ns_.load(std::memory_order_relaxed);
+        while (duration_ns > max &&
+               !max_ns_.compare_exchange_weak(max, duration_ns, std::memory_order_relaxed)) {}
+    }
+
+    /**
+     * @brief Records the duration elapsed since a time of the monotonic clock.
+     *
+     * @param start_ns The start time, as returned by stai_mpu_now_ns().
+     * @return The recorded duration in nanoseconds.
+     */
+    uint64_t record_since(uint64_t start_ns) {
+        uint64_t duration_ns = stai_mpu_now_ns() - start_ns;
+        record(duration_ns);
+        return duration_ns;
+    }
+
+    /**
+     * @brief Computes the statistics of the samples recorded so far. The snapshot is not atomic \
+     * with respect to concurrent calls to record(), which may be partially accounted.
+     *
+     * @return The statistics of the recorded samples.
+     */
+    stai_mpu_stats get_stats() const {
+        stai_mpu_stats stats;
+        uint64_t counts[NUM_BUCKETS];
+        uint64_t total = 0;
+        for (int i = 0; i < NUM_BUCKETS; i++) {
+            counts[i] = buckets_[i].load(std::memory_order_relaxed);
+            total += counts[i];
+        }
+        stats.count = count_.load(std::memory_order_relaxed);
+        if (stats.count == 0 || total == 0)
+            return stats;
+        stats.mean_ms = sum_ns_.load(std::memory_order_relaxed) / 1e6 / stats.count;
+        stats.min_ms = min_ns_.load(std::memory_order_relaxed) / 1e6;
+        stats.max_ms = max_ns_.load(std::memory_order_relaxed) / 1e6;
+        stats.p50_ms = percentile(counts, total, 0.50, stats.min_ms, stats.max_ms);
+        stats.p95_ms = percentile(counts, total, 0.95, stats.min_ms, stats.max_ms);
+        stats.p99_ms = percentile(counts, total, 0.99, stats.min_ms, stats.max_ms);
+        return stats;
+    }
+
+    /**
+     * @brief Drops all the recorded samples.
+     */
+    void reset() {
+        for (int i = 0; i < NUM_BUCKETS; i++)
+            buckets_[i].store(0, std::memory_order_relaxed);
+        count_.store(0, std::memory_order_relaxed);
+        sum_ns_.store(0, std::memory_order_relaxed);
+        min_ns_.store(std::numeric_limits<uint64_t>::max(), std::memory_order_relaxed);
+        max_ns_.store(0, std::memory_order_relaxed);
+    }
+
+private:
+    static constexpr int SUB_BITS = 4;
+    static constexpr int SUB_BUCKETS = 1 << SUB_BITS;
+    static constexpr int MAX_BITS = 32;
+    static constexpr int NUM_BUCKETS = (MAX_BITS - SUB_BITS + 1) * SUB_BUCKETS;
+
+    static int bucket_index(uint64_t us) {
+        if (us >= (1ULL << MAX_BITS))
+            us = (1ULL << MAX_BITS) - 1;
+        if (us < SUB_BUCKETS)
+            return (int)us;
+        int msb = 63 - __builtin_clzll(us);
+        return (msb - SUB_BITS + 1) * SUB_BUCKETS + (int)((us >> (msb - SUB_BITS)) & (SUB_BUCKETS - 1));
+    }
+
+    /* Midpoint of a bucket, in microseconds */
+    static double bucket_value(int index) {
+        if (index < SUB_BUCKETS)
+            return index + 0.5;
+        int group = index / SUB_BUCKETS;
+        uint64_t width = 1ULL << (group - 1);
+        uint64_t lower = (uint64_t)(SUB_BUCKETS + index % SUB_BUCKETS) << (group - 1);
+        return lower + width / 2.0;
+    }
+
+    static double percentile(const uint64_t* counts, uint64_t total, double p, double min_ms, double max_ms) {
+        uint64_t rank = (uint64_t)(p * total + 0.5);
+        if (rank == 0)
+            rank = 1;
+        uint64_t seen = 0;
+        for (int i = 0; i < NUM_BUCKETS; i++) {
+            seen += counts[i];
+            if (seen >= rank) {
+                double value_ms = bucket_value(i) / 1e3;
+                return value_ms < min_ms ? min_ms : (value_ms > max_ms ? max_ms : value_ms);
+            }
+        }
+        return max_ms;
+    }
+
+    std::atomic<uint64_t> buckets_[NUM_BUCKETS];
+    std::atomic<uint64_t> count_;
+    std::atomic<uint64_t> sum_ns_;
+    std::atomic<uint64_t> min_ns_;
+    std::atomic<uint64_t> max_ns_;
+};
+
+#endif //STAI_MPU_STATS_H_
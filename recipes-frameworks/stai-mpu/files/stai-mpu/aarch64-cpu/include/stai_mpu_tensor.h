@@ -58,7 +58,7 @@ public:
      * @brief Gets the name of the tensor.
      * @return The name of the tensor.
      */
-    std::string get_name() const { return name_; }
+    const std::string& get_name() const { return name_; }
 
     /**
      * @brief Gets the index of the tensor.
@@ -70,7 +70,7 @@ public:
      * @brief Gets the shape of the tensor.
      * @return The shape of the tensor.
      */
-    std::vector<int> get_shape() const { return shape_; }
+    const std::vector<int>& get_shape() const { return shape_; }
 
     /**
      * @brief Gets the rank of the tensor.
@@ -94,7 +94,24 @@ public:
      * @brief Gets the quantization parameters of the tensor.
      * @return The quant params of the tensor.
      */
-    stai_mpu_quant_params get_qparams() const { return qparams_;}
+    const stai_mpu_quant_params& get_qparams() const { return qparams_;}
+
+    /**
+     * @brief Gets the number of elements of the tensor, computed from its shape.
+     * @return The number of elements of the tensor.
+     */
+    size_t get_num_elements() const {
+        size_t num_elements = 1;
+        for (int dim : shape_)
+            num_elements *= dim;
+        return num_elements;
+    }
+
+    /**
+     * @brief Gets the size of the tensor data in bytes, computed from its shape and data type.
+     * @return The size of the tensor data in bytes, 0 if the data type is undefined.
+     */
+    size_t get_size_in_bytes() const { return get_num_elements() * stai_mpu_dtype_size(dtype_); }
 
 private:
     /** \brief The name of the tensor. */
@@ -1,9 +1,10 @@
-from typing import List, Tuple, Sequence
+from typing import Any, List, Tuple, Sequence
 from numpy.typing import NDArray
 import numpy as np
 from pathlib import Path
 from stai_mpu import _binding
 from enum import Enum
+import time
 
 class stai_mpu_backend_engine(Enum):
     STAI_MPU_TFLITE_CPU_ENGINE = 0
@@ -23,9 +24,24 @@ class stai_mpu_tensor:
     zero_point: int = ...
     fixed_point_pos: int = ...
 
+def _numpy_dtype(info: Any) -> np.dtype:
+    """Gets the numpy dtype of a tensor. The binding reports a numpy dtype, which also
+    compares equal to its name (get_dtype() == 'float32'); anything numpy cannot take
+    as a numeric dtype is rejected here rather than misread when wrapping the inputs."""
+    reported = info.get_dtype()
+    try:
+        dtype = np.dtype(reported)
+    except TypeError:
+        dtype = None
+    if dtype is None or dtype.kind not in 'biuf':
+        raise TypeError("Unsupported tensor data type {!r} reported by the binding".format(reported))
+    return dtype
+
 class stai_mpu_network:
     def __init__(self, model_path: Path, use_hw_acceleration: bool = True) -> None:
         self._exec = _binding.stai_mpu_network(model_path, use_hw_acceleration)
+        self._input_layouts = [(tuple(info.get_shape()), _numpy_dtype(info))
+                               for info in self._exec.get_input_infos()]
 
     def get_num_inputs(self) -> int:
         return self._exec.get_num_inputs()
@@ -42,8 +58,30 @@ class stai_mpu_network:
     def get_output_infos(self) -> List[stai_mpu_tensor]:
         return self._exec.get_output_infos()
 
-    def set_input(self, index: int, input_tensor: NDArray) -> None:
-        return self._exec.set_input(index, input_tensor)
+    def set_input(self, index: int, input_tensor: Any) -> None:
+        """Sets an input from any object exposing the buffer protocol (numpy array,
+        memoryview of a mapped GStreamer buffer, bytes...). Arrays must already have the
+        dtype of the input tensor, a TypeError being raised otherwise rather than casting
+        e.g. a uint8 frame to a float input; raw buffers holding exactly the tensor bytes
+        are taken as tensor data. Packed data is wrapped without being copied, so that the
+        binding copies it once into the runtime. Data with padded rows, such as stride
+        aligned camera buffers, is first gathered into a contiguous copy, which makes two."""
+        shape, dtype = self._input_layouts[index]
+        size = int(np.prod(shape))
+        if isinstance(input_tensor, np.ndarray):
+            array = input_tensor
+        else:
+            # raw buffers holding exactly the tensor bytes are taken as tensor data
+            view = memoryview(input_tensor)
+            if view.c_contiguous and view.nbytes == size * dtype.itemsize:
+                array = np.frombuffer(view, dtype=dtype)
+            else:
+                array = np.asarray(view)
+        if array.dtype != dtype:
+            raise TypeError("Input {} expects {} data, got {}".format(index, dtype, array.dtype))
+        if array.shape != shape and array.size == size:
+            array = array.reshape(shape)
+        return self._exec.set_input(index, np.ascontiguousarray(array))
 
     def get_output(self, index: int) -> NDArray:
         output_tensor: NDArray = self._exec.get_output(index)
@@ -64,3 +102,20 @@ class stai_mpu_network:
 
     def run(self) -> None:
         self._exec.run()
+
+    def warmup(self, iterations: int = 1) -> Tuple[float, float]:
+        """Runs inferences on zeroed inputs, so that the initializations the backends
+        defer to the first run do not stall the first real inference. The inputs have
+        to be set again afterwards. Returns the duration of the first run and the mean
+        duration of the following ones, in milliseconds."""
+        inputs = [np.zeros(shape, dtype=dtype) for shape, dtype in self._input_layouts]
+        durations: List[float] = []
+        for _ in range(iterations):
+            self.set_inputs(inputs)
+            start = time.perf_counter()
+            self.run()
+            durations.append((time.perf_counter() - start) * 1000.0)
+        if not durations:
+            return (0.0, 0.0)
+        rest = durations[1:]
+        return (durations[0], sum(rest) / len(rest) if rest else 0.0)
@@ -0,0 +1,125 @@
+""" Non maximum suppression of detection boxes given as (x0, y0, x1, y1) corners.
+
+The boxes entering the suppression are the ones above the score threshold,
+limited to the top_k best scored ones by a partial sort. The overlaps of a kept
+box with all the remaining ones are computed as a single vectorized numpy
+expression, so that the Python level loop only runs once per kept box. With
+classes, only the boxes of the same class suppress each other. Degenerate boxes
+never overlap.
+"""
+
+from typing import Optional, Tuple
+from numpy.typing import NDArray
+import numpy as np
+
+
+def _select(scores: NDArray, score_threshold: Optional[float], top_k: int) -> NDArray:
+    """Returns the indexes of the boxes entering the suppression, by decreasing score."""
+    candidates = np.arange(scores.shape[0])
+    if score_threshold is not None:
+        candidates = candidates[scores >= score_threshold]
+    if top_k and candidates.shape[0] > top_k:
+        # The boxes tied with the last selected one are taken by increasing index
+        negated = -scores[candidates]
+        kth = np.partition(negated, top_k - 1)[top_k - 1]
+        better = candidates[negated < kth]
+        tied = candidates[negated == kth][:top_k - better.shape[0]]
+        candidates = np.concatenate((better, tied))
+    return candidates[np.argsort(-scores[candidates], kind="stable")]
+
+
+def _overlaps(x0: NDArray, y0: NDArray, x1: NDArray, y1: NDArray, area: NDArray,
+              i: int, others: NDArray) -> Tuple[NDArray, NDArray]:
+    """Returns the intersections and unions of box i with the other boxes."""
+    w = np.maximum(np.minimum(x1[i], x1[others]) - np.maximum(x0[i], x0[others]), 0)
+    h = np.maximum(np.minimum(y1[i], y1[others]) - np.maximum(y0[i], y0[others]), 0)
+    inter = w * h
+    return inter, area[i] + area[others] - inter
+
+
+def _prepare(boxes: NDArray, order: NDArray):
+    x0, y0, x1, y1 = np.asarray(boxes, dtype=np.float32)[order, :4].T
+    area = np.maximum(x1 - x0, 0) * np.maximum(y1 - y0, 0)
+    return x0, y0, x1, y1, area
+
+
+def non_max_suppression(boxes: NDArray, scores: NDArray, iou_threshold: float = 0.5,
+                        classes: Optional[NDArray] = None, score_threshold: Optional[float] = None,
+                        top_k: int = 0, max_output: int = 0) -> NDArray:
+    """
+    Removes the boxes overlapping a better scored one.
+
+    :param boxes: boxes of shape (N, 4), as x0, y0, x1, y1
+    :param scores: scores of shape (N,)
+    :param iou_threshold: IoU above which two boxes overlap
+    :param classes: classes of shape (N,) for a class aware suppression, None for a class agnostic one
+    :param score_threshold: score under which a box is discarded, None to keep all the boxes
+    :param top_k: number of best scored boxes entering the suppression, 0 for all
+    :param max_output: maximum number of kept boxes, 0 for no limit
+    :return: indexes of the kept boxes, by decreasing score
+    """
+    scores = np.asarray(scores, dtype=np.float32).reshape(-1)
+    order = _select(scores, score_threshold, top_k)
+    x0, y0, x1, y1, area = _prepare(boxes, order)
+    cls = None if classes is None else np.asarray(classes).reshape(-1)[order]
+    keep = []
+    remaining = np.arange(order.shape[0])
+    while remaining.shape[0] > 0:
+        i = remaining[0]
+        keep.append(i)
+        if len(keep) == max_output:
+            break
+        others = remaining[1:]
+        inter, union = _overlaps(x0, y0, x1, y1, area, i, others)
+        overlap = inter > iou_threshold * union
+        if cls is not None:
+            overlap &= cls[others] == cls[i]
+        remaining = others[~overlap]
+    return order[np.asarray(keep, dtype=np.intp)]
+
+
+def soft_non_max_suppression(boxes: NDArray, scores: NDArray, iou_threshold: float = 0.5,
+                             classes: Optional[NDArray] = None, score_threshold: float = 0.0,
+                             top_k: int = 0, max_output: int = 0, method: str = "gaussian",
+                             sigma: float = 0.5) -> Tuple[NDArray, NDArray]:
+    """
+    Decays the scores of the boxes overlapping a better scored one, the boxes whose score
+    falls under the score threshold being removed.
+
+    :param method: "linear" to multiply the scores of the boxes overlapping over the IoU
+        threshold by (1 - IoU), "gaussian" to multiply all the scores by exp(-IoU^2 / sigma)
+    :param sigma: sigma of the gaussian decay
+    :return: indexes of the kept boxes and their decayed scores, by decreasing score
+
+    The other parameters are the ones of non_max_suppression().
+    """
+    if method not in ("linear", "gaussian"):
+        raise ValueError("Unsupported soft suppression method " + method)
+    scores = np.asarray(scores, dtype=np.float32).reshape(-1)
+    order = _select(scores, score_threshold, top_k)
+    x0, y0, x1, y1, area = _prepare(boxes, order)
+    cls = None if classes is None else np.asarray(classes).reshape(-1)[order]
+    decayed = scores[order].copy()
+    keep = []
+    remaining = np.arange(order.shape[0])
+    while remaining.shape[0] > 0:
+        best = np.argmax(decayed[remaining])
+        i = remaining[best]
+        if decayed[i] < score_threshold:
+            break
+        keep.append(i)
+        if len(keep) == max_output:
+            break
+        remaining = np.delete(remaining, best)
+        inter, union = _overlaps(x0, y0, x1, y1, area, i, remaining)
+        with np.errstate(divide="ignore", invalid="ignore"):
+            iou = np.where(union > 0, inter / union, 0)
+        if method == "gaussian":
+            decay = np.exp(-iou * iou / sigma)
+        else:
+            decay = np.where(iou > iou_threshold, 1 - iou, 1)
+        if cls is not None:
+            decay = np.where(cls[remaining] == cls[i], decay, 1)
+        decayed[remaining] *= decay
+    keep = np.asarray(keep, dtype=np.intp)
+    return order[keep], decayed[keep]
@@ -0,0 +1,95 @@
+""" Quantization helpers working on the quantization parameters of the stai_mpu_tensor.
+
+The affine functions compute real = (q - zero_point) * scale and
+q = round(real / scale) + zero_point, the dynamic fixed point ones
+real = q * 2^-fixed_point_pos. The rounding is to the nearest, ties to even,
+and the quantized values are saturated to the range of their type. All the
+functions are vectorized numpy expressions, without Python level loops.
+"""
+
+from typing import Optional
+from numpy.typing import NDArray, DTypeLike
+import numpy as np
+
+
+def dequantize(data: NDArray, scale: float, zero_point: int, out: Optional[NDArray] = None) -> NDArray:
+    """Dequantizes affine quantized values to float32."""
+    if out is None:
+        out = np.empty(data.shape, dtype=np.float32)
+    np.subtract(data, np.int32(zero_point), out=out, dtype=np.float32)
+    np.multiply(out, np.float32(scale), out=out)
+    return out
+
+
+def quantize(data: NDArray, scale: float, zero_point: int, dtype: DTypeLike = np.uint8) -> NDArray:
+    """Quantizes real values with an affine quantization."""
+    info = np.iinfo(dtype)
+    q = np.rint(np.asarray(data, dtype=np.float32) * np.float32(1.0 / scale)) + np.float32(zero_point)
+    return np.clip(q, info.min, info.max).astype(dtype)
+
+
+def requantize(data: NDArray, in_scale: float, in_zero_point: int,
+               out_scale: float, out_zero_point: int, dtype: DTypeLike = np.uint8) -> NDArray:
+    """Requantizes affine quantized values from one set of quantization parameters to another."""
+    return quantize(dequantize(data, in_scale, in_zero_point), out_scale, out_zero_point, dtype)
+
+
+def dequantize_per_channel(data: NDArray, scales: NDArray, zero_points: NDArray, axis: int = -1) -> NDArray:
+    """Dequantizes per-channel affine quantized values, the channels being along axis."""
+    shape = [1] * data.ndim
+    shape[axis] = -1
+    scales = np.asarray(scales, dtype=np.float32).reshape(shape)
+    zero_points = np.asarray(zero_points, dtype=np.int32).reshape(shape)
+    return (data.astype(np.int32) - zero_points).astype(np.float32) * scales
+
+
+def quantize_per_channel(data: NDArray, scales: NDArray, zero_points: NDArray, axis: int = -1,
+                         dtype: DTypeLike = np.uint8) -> NDArray:
+    """Quantizes real values with a per-channel affine quantization, the channels being along axis."""
+    data = np.asarray(data, dtype=np.float32)
+    shape = [1] * data.ndim
+    shape[axis] = -1
+    inv_scales = (1.0 / np.asarray(scales, dtype=np.float32)).reshape(shape)
+    zero_points = np.asarray(zero_points, dtype=np.float32).reshape(shape)
+    info = np.iinfo(dtype)
+    return np.clip(np.rint(data * inv_scales) + zero_points, info.min, info.max).astype(dtype)
+
+
+def dequantize_dfp(data: NDArray, fixed_point_pos: int) -> NDArray:
+    """Dequantizes dynamic fixed point values to float32."""
+    return dequantize(data, 2.0 ** -fixed_point_pos, 0)
+
+
+def quantize_dfp(data: NDArray, fixed_point_pos: int, dtype: DTypeLike = np.int8) -> NDArray:
+    """Quantizes real values with a dynamic fixed point quantization."""
+    return quantize(data, 2.0 ** -fixed_point_pos, 0, dtype)
+
+
+def _qtype_of(tensor) -> str:
+    qtype = str(tensor.qtype).upper()
+    if "AFFINE" in qtype:
+        return "affine"
+    if "DYNAMIC" in qtype or "DFP" in qtype:
+        return "dfp"
+    return "none"
+
+
+def dequantize_tensor(tensor, data: NDArray, out: Optional[NDArray] = None) -> NDArray:
+    """Dequantizes the data of a tensor according to the quantization parameters of its stai_mpu_tensor.
+    Float data is returned as float32 without rescaling."""
+    qtype = _qtype_of(tensor)
+    if np.issubdtype(data.dtype, np.floating) or qtype == "none":
+        return data.astype(np.float32, copy=False)
+    if qtype == "dfp":
+        return dequantize(data, 2.0 ** -tensor.fixed_point_pos, 0, out)
+    return dequantize(data, tensor.scale, tensor.zero_point, out)
+
+
+def quantize_tensor(tensor, data: NDArray, dtype: DTypeLike) -> NDArray:
+    """Quantizes real values for a tensor according to the quantization parameters of its stai_mpu_tensor."""
+    qtype = _qtype_of(tensor)
+    if np.issubdtype(np.dtype(dtype), np.floating) or qtype == "none":
+        return np.asarray(data, dtype=dtype)
+    if qtype == "dfp":
+        return quantize_dfp(data, tensor.fixed_point_pos, dtype)
+    return quantize(data, tensor.scale, tensor.zero_point, dtype)
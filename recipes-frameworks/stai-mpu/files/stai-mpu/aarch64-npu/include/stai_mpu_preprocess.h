@@ -0,0 +1,321 @@
+/*
+ * Copyright (c) 2024 STMicroelectronics.
+ * All rights reserved.
+ *
+ * This software is licensed under terms that can be found in the LICENSE file
+ * in the root directory of this software component.
+ * If no LICENSE file comes with this software, it is provided AS-IS.
+ *
+ */
+
+#ifndef STAI_MPU_PREPROCESS_H_
+#define STAI_MPU_PREPROCESS_H_
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+#include "stai_mpu_types.h"
+#include "stai_mpu_tensor.h"
+#include "stai_mpu_quant.h"
+
+/*
+ * Conversion of uint8 HWC frames into the exact input of a model in a single pass: normalization
+ * real = (pixel - mean) / std, conversion to the data type of the input tensor (float32, float16,
+ * or uint8/int8/int16 quantized with the tensor quantization parameters) and NHWC or NCHW layout.
+ * Runtimes converting the half precision inputs themselves, as the OVX backend does, are given
+ * float32 data for these inputs instead.
+ * Float32 inputs are computed as pixel * (1 / std) - mean / std, vectorized with NEON when
+ * available. Every other data type is a per channel lookup table of the 256 pixel values, built
+ * once with the stai_mpu_quant kernels, so the per element work is a single load.
+ *
+ * Quantized inputs receive quantize((pixel - mean) / std), not the raw pixels the samples used to
+ * copy into every non float32 input. Both only agree when the tensor is quantized with
+ * scale = 1 / std and zero_point = mean: with the 127.5 mean and std the samples pass by default,
+ * an int8 input quantized with scale 1/127.5 and zero_point -1 receives pixel - 128 within one
+ * step, where the raw copy gave the pixel byte reinterpreted as int8. A uint8 input quantized for
+ * raw pixels (scale 1, zero_point 0) must be given the frame as is rather than go through the
+ * preprocessor, as the sample wrappers do.
+ *
+ * run() converts the whole frame on the calling thread. Callers with their own worker threads
+ * may instead split the rows into bands converted concurrently with run_rows(); the preprocessor
+ * creates no thread itself.
+ */
+
+#define STAI_MPU_PREPROCESS_MAX_CHANNELS 4
+
+enum class stai_mpu_layout {
+    STAI_MPU_LAYOUT_NHWC,
+    STAI_MPU_LAYOUT_NCHW
+};
+
+struct stai_mpu_preprocess_params {
+    int width = 0;
+    int height = 0;
+    int channels = 3;
+    float mean[STAI_MPU_PREPROCESS_MAX_CHANNELS] = {127.5f, 127.5f, 127.5f, 127.5f};
+    float std_dev[STAI_MPU_PREPROCESS_MAX_CHANNELS] = {127.5f, 127.5f, 127.5f, 127.5f};
+    stai_mpu_layout layout = stai_mpu_layout::STAI_MPU_LAYOUT_NHWC;
+    /* Emit float32 for the FLOAT16 and BFLOAT16 tensors, for the runtimes converting them from
+     * float32 themselves, such as the OVX backend */
+    bool half_as_float = false;
+
+    /**
+     * @brief Sets the same normalization for all the channels.
+     *
+     * @param mean_value The mean subtracted from the pixels.
+     * @param std_value The standard deviation the pixels are divided by.
+     */
+    void set_normalization(float mean_value, float std_value) {
+        for (int c = 0; c < STAI_MPU_PREPROCESS_MAX_CHANNELS; c++) {
+            mean[c] = mean_value;
+            std_dev[c] = std_value;
+        }
+    }
+};
+
+class stai_mpu_preprocessor {
+public:
+    /**
+     * @brief Prepares the conversion of frames into the data of an input tensor.
+     *
+     * @param tensor The input tensor information.
+     * @param params The frame geometry, the normalization and the layout of the input tensor.
+     * @throws std::runtime_error If the geometry does not match the tensor or the data type is not supported.
+     */
+    stai_mpu_preprocessor(const stai_mpu_tensor& tensor, const stai_mpu_preprocess_params& params)
+        : params_(params), dtype_(tensor.get_dtype()) {
+        if (params_.half_as_float && (dtype_ == stai_mpu_dtype::STAI_MPU_DTYPE_FLOAT16 ||
+                                      dtype_ == stai_mpu_dtype::STAI_MPU_DTYPE_BFLOAT16))
+            dtype_ = stai_mpu_dtype::STAI_MPU_DTYPE_FLOAT32;
+        if (params_.channels < 1 || params_.channels > STAI_MPU_PREPROCESS_MAX_CHANNELS)
+            throw std::runtime_error("[PREPROCESS] Unsupported number of channels");
+        if ((size_t)params_.width * params_.height * params_.channels != tensor.get_num_elements())
+            throw std::runtime_error("[PREPROCESS] Frame geometry does not match the tensor " + tensor.get_name());
+        uniform_ = true;
+        for (int c = 0; c < params_.channels; c++) {
+            scale_[c] = 1.0f / params_.std_dev[c];
+            offset_[c] = -params_.mean[c] / params_.std_dev[c];
+            if (scale_[c] != scale_[0] || offset_[c] != offset_[0])
+                uniform_ = false;
+        }
+        elem_size_ = stai_mpu_dtype_size(dtype_);
+        if (dtype_ != stai_mpu_dtype::STAI_MPU_DTYPE_FLOAT32)
+            build_lut(tensor);
+    }
+
+    /**
+     * @brief Gets the size of the converted frame.
+     *
+     * @return The size in bytes written by run().
+     */
+    size_t get_output_size_in_bytes() const {
+        return (size_t)params_.width * params_.height * params_.channels * elem_size_;
+    }
+
+    /**
+     * @brief Converts a frame into the data of the input tensor.
+     *
+     * @param src The uint8 HWC frame.
+     * @param dst The tensor data, of get_output_size_in_bytes() bytes.
+     * @param src_row_stride The number of bytes between two rows of the frame, e.g. with the
+     * padding of hardware aligned camera buffers. 0 for packed rows.
+     * @throws std::runtime_error If the stride is smaller than a row.
+     */
+    void run(const uint8_t* src, void* dst, size_t src_row_stride = 0) const {
+        size_t row_bytes = (size_t)params_.width * params_.channels;
+        if (src_row_stride == 0)
+            src_row_stride = row_bytes;
+        if (src_row_stride < row_bytes)
+            throw std::runtime_error("[PREPROCESS] Row stride smaller than a row of the frame");
+        convert_rows(src, dst, src_row_stride, 0, params_.height);
+    }
+
+    /**
+     * @brief Converts a band of rows of a frame. The bands of a partition of the rows write
+     * disjoint parts of the tensor data, so that they can be converted concurrently by threads
+     * owned by the caller.
+     *
+     * @param src The uint8 HWC frame, pointing to its first row whatever the band is.
+     * @param dst The tensor data, of get_output_size_in_bytes() bytes.
+     * @param src_row_stride The number of bytes between two rows of the frame. 0 for packed rows.
+     * @param row_begin The first row of the band.
+     * @param row_end The row following the last row of the band.
+     * @throws std::runtime_error If the stride is smaller than a row or the band is out of the frame.
+     */
+    void run_rows(const uint8_t* src, void* dst, size_t src_row_stride, int row_begin, int row_end) const {
+        size_t row_bytes = (size_t)params_.width * params_.channels;
+        if (src_row_stride == 0)
+            src_row_stride = row_bytes;
+        if (src_row_stride < row_bytes)
+            throw std::runtime_error("[PREPROCESS] Row stride smaller than a row of the frame");
+        if (row_begin < 0 || row_begin > row_end || row_end > params_.height)
+            throw std::runtime_error("[PREPROCESS] Rows out of the frame");
+        convert_rows(src, dst, src_row_stride, row_begin, row_end);
+    }
+
+private:
+    void build_lut(const stai_mpu_tensor& tensor) {
+        const stai_mpu_quant_params& qparams = tensor.get_qparams();
+        stai_mpu_qtype qtype = tensor.get_qtype();
+        float scale = 1.0f;
+        int32_t zero_point = 0;
+        if (qtype == stai_mpu_qtype::STAI_MPU_QTYPE_STATIC_AFFINE) {
+            scale = qparams.static_affine.scale;
+            zero_point = (int32_t)qparams.static_affine.zero_point;
+        } else if (qtype == stai_mpu_qtype::STAI_MPU_QTYPE_DYNAMIC_FIXED_POINT) {
+            scale = std::ldexp(1.0f, -qparams.dfp.fixed_point_pos);
+        }
+        lut_.resize((size_t)params_.channels * 256 * elem_size_);
+        float real[256];
+        for (int c = 0; c < params_.channels; c++) {
+            for (int x = 0; x < 256; x++)
+                real[x] = x * scale_[c] + offset_[c];
+            void* lut = lut_.data() + (size_t)c * 256 * elem_size_;
+            switch (dtype_) {
+                case stai_mpu_dtype::STAI_MPU_DTYPE_UINT8:
+                    stai_mpu_quantize(real, static_cast<uint8_t*>(lut), 256, scale, zero_point);
+                    break;
+                case stai_mpu_dtype::STAI_MPU_DTYPE_INT8:
+                    stai_mpu_quantize(real, static_cast<int8_t*>(lut), 256, scale, zero_point);
+                    break;
+                case stai_mpu_dtype::STAI_MPU_DTYPE_INT16:
+                    stai_mpu_quantize(real, static_cast<int16_t*>(lut), 256, scale, zero_point);
+                    break;
+                case stai_mpu_dtype::STAI_MPU_DTYPE_FLOAT16:
+                    stai_mpu_fp32_to_fp16_array(real, static_cast<uint16_t*>(lut), 256);
+                    break;
+                default:
+                    throw std::runtime_error("[PREPROCESS] Unsupported data type for the tensor " + tensor.get_name());
+            }
+        }
+    }
+
+    /* Converts rows [row_begin, row_end), packed rows being converted as a single span */
+    void convert_rows(const uint8_t* src, void* dst, size_t src_row_stride, int row_begin, int row_end) const {
+        size_t row_bytes = (size_t)params_.width * params_.channels;
+        if (src_row_stride == row_bytes) {
+            run_span(src + row_begin * row_bytes, dst, (size_t)row_begin * params_.width,
+                     (size_t)(row_end - row_begin) * params_.width);
+            return;
+        }
+        for (int row = row_begin; row < row_end; row++)
+            run_span(src + row * src_row_stride, dst, (size_t)row * params_.width, params_.width);
+    }
+
+    /* Converts count pixels starting at pixel begin of the tensor, src pointing to the first one */
+    void run_span(const uint8_t* src, void* dst, size_t begin, size_t count) const {
+        switch (elem_size_) {
+            case 1:
+                lut_span(src, static_cast<uint8_t*>(dst), reinterpret_cast<const uint8_t*>(lut_.data()), begin, count);
+                break;
+            case 2:
+                lut_span(src, static_cast<uint16_t*>(dst), reinterpret_cast<const uint16_t*>(lut_.data()), begin, count);
+                break;
+            default:
+                float_span(src, static_cast<float*>(dst), begin, count);
+                break;
+        }
+    }
+
+    template<typename T>
+    void lut_span(const uint8_t* src, T* dst, const T* lut, size_t begin, size_t count) const {
+        const int channels = params_.channels;
+        const size_t plane = (size_t)params_.width * params_.height;
+        if (params_.layout == stai_mpu_layout::STAI_MPU_LAYOUT_NCHW) {
+            for (int c = 0; c < channels; c++) {
+                const T* lut_c = lut + c * 256;
+                T* plane_c = dst + c * plane + begin;
+                for (size_t p = 0; p < count; p++)
+                    plane_c[p] = lut_c[src[p * channels + c]];
+            }
+        } else if (uniform_ || channels == 1) {
+            dst += begin * channels;
+            for (size_t i = 0; i < count * channels; i++)
+                dst[i] = lut[src[i]];
+        } else {
+            dst += begin * channels;
+            for (size_t p = 0; p < count; p++)
+                for (int c = 0; c < channels; c++)
+                    dst[p * channels + c] = lut[c * 256 + src[p * channels + c]];
+        }
+    }
+
+    void float_span(const uint8_t* src, float* dst, size_t begin, size_t count) const {
+        const int channels = params_.channels;
+        const size_t plane = (size_t)params_.width * params_.height;
+        const bool nchw = params_.layout == stai_mpu_layout::STAI_MPU_LAYOUT_NCHW;
+        size_t p = 0;
+        if (!nchw && (uniform_ || channels == 1)) {
+            dst += begin * channels;
+            size_t i = 0;
+#ifdef STAI_MPU_QUANT_NEON
+            const float32x4_t scale = vdupq_n_f32(scale_[0]);
+            const float32x4_t offset = vdupq_n_f32(offset_[0]);
+            for (; i + 16 <= count * channels; i += 16)
+                normalize_u8x16(vld1q_u8(src + i), scale, offset, dst + i);
+#endif
+            for (; i < count * channels; i++)
+                dst[i] = src[i] * scale_[0] + offset_[0];
+            return;
+        }
+#ifdef STAI_MPU_QUANT_NEON
+        if (channels == 3) {
+            float32x4_t scale[3], offset[3];
+            for (int c = 0; c < 3; c++) {
+                scale[c] = vdupq_n_f32(scale_[c]);
+                offset[c] = vdupq_n_f32(offset_[c]);
+            }
+            for (; p + 16 <= count; p += 16) {
+                uint8x16x3_t pixels = vld3q_u8(src + p * 3);
+                if (nchw) {
+                    for (int c = 0; c < 3; c++)
+                        normalize_u8x16(pixels.val[c], scale[c], offset[c], dst + c * plane + begin + p);
+                } else {
+                    float planar[3][16];
+                    for (int c = 0; c < 3; c++)
+                        normalize_u8x16(pixels.val[c], scale[c], offset[c], planar[c]);
+                    for (int k = 0; k < 16; k += 4) {
+                        float32x4x3_t interleaved;
+                        for (int c = 0; c < 3; c++)
+                            interleaved.val[c] = vld1q_f32(planar[c] + k);
+                        vst3q_f32(dst + (begin + p + k) * 3, interleaved);
+                    }
+                }
+            }
+        }
+#endif
+        for (; p < count; p++)
+            for (int c = 0; c < channels; c++) {
+                float value = src[p * channels + c] * scale_[c] + offset_[c];
+                if (nchw)
+                    dst[c * plane + begin + p] = value;
+                else
+                    dst[(begin + p) * channels + c] = value;
+            }
+    }
+
+#ifdef STAI_MPU_QUANT_NEON
+    /* Normalizes 16 pixels of one channel into 16 consecutive floats */
+    static void normalize_u8x16(uint8x16_t pixels, float32x4_t scale, float32x4_t offset, float* out) {
+        uint16x8_t low = vmovl_u8(vget_low_u8(pixels));
+        uint16x8_t high = vmovl_u8(vget_high_u8(pixels));
+        uint32x4_t quarters[4] = {vmovl_u16(vget_low_u16(low)), vmovl_u16(vget_high_u16(low)),
+                                  vmovl_u16(vget_low_u16(high)), vmovl_u16(vget_high_u16(high))};
+        for (int k = 0; k < 4; k++)
+            vst1q_f32(out + 4 * k, vmlaq_f32(offset, vcvtq_f32_u32(quarters[k]), scale));
+    }
+#endif
+
+    stai_mpu_preprocess_params params_;
+    stai_mpu_dtype dtype_;
+    size_t elem_size_;
+    bool uniform_;
+    float scale_[STAI_MPU_PREPROCESS_MAX_CHANNELS];
+    float offset_[STAI_MPU_PREPROCESS_MAX_CHANNELS];
+    std::vector<uint8_t> lut_;
+};
+
+#endif //STAI_MPU_PREPROCESS_H_
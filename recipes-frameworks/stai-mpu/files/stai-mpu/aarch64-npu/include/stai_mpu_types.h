@@ -56,6 +56,37 @@ enum stai_mpu_dtype {
     STAI_MPU_DTYPE_UNDEFINED,
 };
 
+/**
+ * @brief Returns the size in bytes of one element of the given data type.
+ * @param dtype The data type.
+ * @return The element size in bytes, 0 if the data type is undefined.
+ */
+inline size_t stai_mpu_dtype_size(stai_mpu_dtype dtype) {
+    switch (dtype) {
+        case STAI_MPU_DTYPE_INT8:
+        case STAI_MPU_DTYPE_UINT8:
+        case STAI_MPU_DTYPE_BOOL8:
+        case STAI_MPU_DTYPE_CHAR:
+            return 1;
+        case STAI_MPU_DTYPE_INT16:
+        case STAI_MPU_DTYPE_UINT16:
+        case STAI_MPU_DTYPE_BFLOAT16:
+        case STAI_MPU_DTYPE_FLOAT16:
+            return 2;
+        case STAI_MPU_DTYPE_INT32:
+        case STAI_MPU_DTYPE_UINT32:
+        case STAI_MPU_DTYPE_FLOAT32:
+            return 4;
+        case STAI_MPU_DTYPE_INT64:
+        case STAI_MPU_DTYPE_UINT64:
+        case STAI_MPU_DTYPE_FLOAT64:
+            return 8;
+        case STAI_MPU_DTYPE_UNDEFINED:
+        default:
+            return 0;
+    }
+}
+
 /**
  * @brief An enumeration of the supported quantization type
  */
@@ -3,4 +3,5 @@
 __version__ = "6.0.1"
 __author__ = "STMicroelectronics"
 
-from .stai_mpu.network import stai_mpu_network, stai_mpu_tensor, stai_mpu_backend_engine
\ No newline at end of file
+from .stai_mpu.network import stai_mpu_network, stai_mpu_tensor, stai_mpu_backend_engine
+from .stai_mpu import quant, preprocess, nms
\ No newline at end of file
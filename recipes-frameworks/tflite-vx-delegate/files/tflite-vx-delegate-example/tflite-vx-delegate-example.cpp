@@ -21,6 +21,16 @@
 #include <time.h>
 #include <iostream>
 #include <thread>
+#include <chrono>
+#include <fstream>
+#include <map>
+#include <cerrno>
+#include <cstring>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <sys/utsname.h>
+#include <unistd.h>
+#include "tensorflow/lite/core/api/profiler.h"
 #include "tensorflow/lite/kernels/register.h"
 #include "tensorflow/lite/model.h"
 #include "tensorflow/lite/optional_debug_tools.h"
@@ -30,6 +40,82 @@
 
 #define LOG(x) std::cerr
 
+/*
+ * Profiler recording the begin and end time of each operator invocation.
+ * A partition of the graph taken by the VX delegate shows up as a single
+ * operator, so the trace tells which parts of the model run on the NPU and
+ * which ones fall back to the CPU kernels.
+ */
+class OpProfiler : public tflite::Profiler {
+public:
+    struct Event {
+        std::string tag;
+        int64_t node_index;
+        uint64_t begin_us;
+        uint64_t end_us;
+    };
+
+    using tflite::Profiler::BeginEvent;
+    using tflite::Profiler::EndEvent;
+
+    uint32_t BeginEvent(const char* tag, EventType event_type, int64_t event_metadata1,
+                        int64_t event_metadata2) override {
+        if (event_type != EventType::OPERATOR_INVOKE_EVENT &&
+            event_type != EventType::DELEGATE_OPERATOR_INVOKE_EVENT)
+            return 0;
+        events_.push_back({tag ? tag : "", event_metadata1, now_us(), 0});
+        return events_.size();
+    }
+
+    void EndEvent(uint32_t event_handle) override {
+        if (event_handle == 0 || event_handle > events_.size())
+            return;
+        events_[event_handle - 1].end_us = now_us();
+    }
+
+    // Dump the events in the Chrome trace JSON format (chrome://tracing, Perfetto)
+    bool WriteChromeTrace(const std::string& path) const {
+        std::ofstream file(path);
+        if (!file)
+            return false;
+        file << "{\"traceEvents\":[";
+        for (size_t i = 0; i < events_.size(); ++i) {
+            const Event& event = events_[i];
+            file << (i ? ",\n" : "\n")
+                 << "{\"name\":\"" << event.tag << "\",\"cat\":\"op\",\"ph\":\"X\""
+                 << ",\"ts\":" << event.begin_us << ",\"dur\":" << event.end_us - event.begin_us
+                 << ",\"pid\":0,\"tid\":0,\"args\":{\"node\":" << event.node_index << "}}";
+        }
+        file << "\n]}\n";
+        return file.good();
+    }
+
+    // Print the time spent per operator type
+    void PrintSummary() const {
+        std::map<std::string, std::pair<int, uint64_t>> per_op;
+        uint64_t total_us = 0;
+        for (const Event& event : events_) {
+            per_op[event.tag].first++;
+            per_op[event.tag].second += event.end_us - event.begin_us;
+            total_us += event.end_us - event.begin_us;
+        }
+        std::cout << "Operator profile (count, total time, share):" << std::endl;
+        for (const auto& op : per_op) {
+            std::cout << "  " << op.first << ": " << op.second.first << ", "
+                      << op.second.second / 1000.0 << " ms, "
+                      << (total_us ? 100.0 * op.second.second / total_us : 0.0) << " %" << std::endl;
+        }
+    }
+
+private:
+    static uint64_t now_us() {
+        return std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    std::vector<Event> events_;
+};
+
 void generate_input_data(const TfLiteTensor* tensor, std::vector<uint8_t>& uint8_data, std::vector<int8_t>& int8_data, std::vector<float>& float_data) {
     switch (tensor->type) {
         case kTfLiteUInt8: {
@@ -95,7 +181,90 @@ void retrieve_output_data(const TfLiteTensor* tensor) {
     }
 }
 
-void run_inference(const std::string& model_file) {
+/*
+ * Compiled graph cache of the VX delegate. With allowed_cache_mode the delegate
+ * loads the NBG graph from cache_file_path when the file exists, and compiles
+ * the graph then writes it there otherwise. The delegate does not check that
+ * the file matches the model, so the file name holds a key made of the model
+ * content hash, the NPU driver version and the delegate library: changing any
+ * of them selects a new file, and the stale files of the model are removed.
+ */
+static void fnv1a_update(uint64_t& hash, const void* data, size_t size) {
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    for (size_t i = 0; i < size; i++) {
+        hash ^= bytes[i];
+        hash *= 0x100000001b3ULL;
+    }
+}
+
+static std::string read_first_line(const char* path) {
+    std::ifstream file(path);
+    std::string line;
+    std::getline(file, line);
+    return line;
+}
+
+static bool npu_cache_key(const std::string& model_file, const char* delegate_path, uint64_t& key) {
+    key = 0xcbf29ce484222325ULL;
+    std::ifstream model(model_file, std::ios::binary);
+    if (!model)
+        return false;
+    std::vector<char> chunk(1 << 20);
+    while (model.read(chunk.data(), chunk.size()) || model.gcount() > 0)
+        fnv1a_update(key, chunk.data(), model.gcount());
+
+    /* The galcore module version when exported, the kernel release otherwise */
+    std::string driver = read_first_line("/sys/module/galcore/version");
+    if (driver.empty()) {
+        struct utsname name;
+        if (uname(&name) == 0)
+            driver = name.release;
+    }
+    fnv1a_update(key, driver.data(), driver.size());
+
+    struct stat delegate_stat;
+    if (stat(delegate_path, &delegate_stat) == 0) {
+        fnv1a_update(key, &delegate_stat.st_size, sizeof(delegate_stat.st_size));
+        fnv1a_update(key, &delegate_stat.st_mtime, sizeof(delegate_stat.st_mtime));
+    }
+    return true;
+}
+
+static std::string npu_cache_file(const std::string& cache_dir, const std::string& model_file,
+                                  const char* delegate_path) {
+    uint64_t key;
+    if (!npu_cache_key(model_file, delegate_path, key))
+        return "";
+    if (mkdir(cache_dir.c_str(), 0755) != 0 && errno != EEXIST)
+        return "";
+
+    std::string stem = model_file.substr(model_file.find_last_of('/') + 1);
+    stem = stem.substr(0, stem.find_last_of('.'));
+    char key_str[17];
+    snprintf(key_str, sizeof(key_str), "%016llx", (unsigned long long)key);
+    std::string cache_name = stem + "-" + key_str + ".nb";
+
+    /* Invalidate the entries of the model compiled with another key */
+    DIR* dir = opendir(cache_dir.c_str());
+    if (dir) {
+        struct dirent* entry;
+        while ((entry = readdir(dir)) != nullptr) {
+            std::string name = entry->d_name;
+            if (name != cache_name && name.size() == cache_name.size() &&
+                name.compare(0, stem.size() + 1, stem + "-") == 0 &&
+                name.compare(name.size() - 3, 3, ".nb") == 0)
+                unlink((cache_dir + "/" + name).c_str());
+        }
+        closedir(dir);
+    }
+    return cache_dir + "/" + cache_name;
+}
+
+void run_inference(const std::string& model_file, const std::string& profile_file,
+                   const std::string& cache_dir) {
+    // Declared first so that it outlives the interpreter
+    OpProfiler profiler;
+
     // Load the TFLite model
     std::unique_ptr<tflite::FlatBufferModel> model;
 	std::unique_ptr<tflite::Interpreter> interpreter;
@@ -126,8 +295,20 @@ void run_inference(const std::string& model_file) {
 
     const char * delegate_path = "/usr/lib/libvx_delegate.so.2";
     auto ext_delegate_option = TfLiteExternalDelegateOptionsDefault(delegate_path);
-    // ext_delegate_option.insert(&ext_delegate_option, "cache_file_path", "path/to/nbfile");
-    // ext_delegate_option.insert(&ext_delegate_option, "allowed_cache_mode", "true");
+    // Kept alive until the delegate is created, the options only point to it
+    std::string cache_file;
+    if (!cache_dir.empty()) {
+        cache_file = npu_cache_file(cache_dir, model_file, delegate_path);
+        if (cache_file.empty()) {
+            std::cerr << "Compiled graph cache disabled, failed to use " << cache_dir << std::endl;
+        } else {
+            struct stat cache_stat;
+            std::cout << "Compiled graph cache " << cache_file
+                      << (stat(cache_file.c_str(), &cache_stat) == 0 ? " (hit)" : " (miss)") << std::endl;
+            ext_delegate_option.insert(&ext_delegate_option, "cache_file_path", cache_file.c_str());
+            ext_delegate_option.insert(&ext_delegate_option, "allowed_cache_mode", "true");
+        }
+    }
     auto ext_delegate_ptr = TfLiteExternalDelegateCreate(&ext_delegate_option);
     interpreter->ModifyGraphWithDelegate(ext_delegate_ptr);
 
@@ -167,11 +348,25 @@ void run_inference(const std::string& model_file) {
             return;
     }
 
-    // Run inference
+    // Run inference, the first one compiling the graph or loading it from the cache
+    auto start = std::chrono::steady_clock::now();
     if (interpreter->Invoke() != kTfLiteOk) {
         LOG(FATAL) << "Failed to invoke tflite!\n";
     } else {
-        LOG(INFO) << "Inference done ! \n";
+        auto duration = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start);
+        LOG(INFO) << "Inference done in " << duration.count() << " ms ! \n";
+    }
+
+    if (!profile_file.empty()) {
+        // Profiled run, so that the profile does not include the graph compilation
+        interpreter->SetProfiler(&profiler);
+        interpreter->Invoke();
+        interpreter->SetProfiler(nullptr);
+        profiler.PrintSummary();
+        if (profiler.WriteChromeTrace(profile_file))
+            std::cout << "Profile trace written to " << profile_file << std::endl;
+        else
+            std::cerr << "Failed to write the profile trace " << profile_file << std::endl;
     }
 
     // Retrieve and print output data for each output tensor
@@ -185,12 +380,21 @@ void run_inference(const std::string& model_file) {
 }
 
 int main(int argc, char* argv[]) {
-    if (argc != 2) {
-        fprintf(stderr, "Usage: %s <model_path>\n", argv[0]);
+    std::string cache_dir;
+    std::vector<std::string> args;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--cache_dir") == 0 && i + 1 < argc)
+            cache_dir = argv[++i];
+        else
+            args.push_back(argv[i]);
+    }
+    if (args.size() != 1 && args.size() != 2) {
+        fprintf(stderr, "Usage: %s [--cache_dir <dir>] <model_path> [profile_trace.json]\n", argv[0]);
         return 1;
     }
 
-    std::string model_path = argv[1];
-    run_inference(model_path);
+    std::string model_path = args[0];
+    std::string profile_file = args.size() == 2 ? args[1] : "";
+    run_inference(model_path, profile_file, cache_dir);
     return 0;
 }
\ No newline at end of file
@@ -13,11 +13,51 @@ import argparse
 import numpy as np
 import tflite_runtime.interpreter as tf
 from timeit import default_timer as timer
+import hashlib
 import os
 
-def run_inference(model_path):
+DELEGATE_PATH = '/usr/lib/libvx_delegate.so.2'
+
+def npu_cache_file(cache_dir, model_path):
+    """
+    Compiled graph cache of the VX delegate. With allowed_cache_mode the delegate
+    loads the NBG graph from cache_file_path when the file exists, and compiles
+    the graph then writes it there otherwise. The delegate does not check that
+    the file matches the model, so the file name holds a key made of the model
+    content hash, the NPU driver version and the delegate library: changing any
+    of them selects a new file, and the stale files of the model are removed.
+    """
+    key = hashlib.sha1()
+    with open(model_path, 'rb') as model:
+        for chunk in iter(lambda: model.read(1 << 20), b''):
+            key.update(chunk)
+    # The galcore module version when exported, the kernel release otherwise
+    try:
+        with open('/sys/module/galcore/version') as version:
+            driver = version.readline().strip()
+    except OSError:
+        driver = os.uname().release
+    key.update(driver.encode())
+    delegate_stat = os.stat(DELEGATE_PATH)
+    key.update(('%d-%d' % (delegate_stat.st_size, int(delegate_stat.st_mtime))).encode())
+
+    os.makedirs(cache_dir, exist_ok=True)
+    stem = os.path.splitext(os.path.basename(model_path))[0]
+    cache_name = '%s-%s.nb' % (stem, key.hexdigest()[:16])
+    # Invalidate the entries of the model compiled with another key
+    for name in os.listdir(cache_dir):
+        if name != cache_name and len(name) == len(cache_name) and name.startswith(stem + '-') and name.endswith('.nb'):
+            os.remove(os.path.join(cache_dir, name))
+    return os.path.join(cache_dir, cache_name)
+
+def run_inference(model_path, cache_dir=None):
     # Load the TFLite model and allocate tensors
-    interpreter = tf.Interpreter(model_path=model_path, num_threads = os.cpu_count(), experimental_delegates=[tf.load_delegate('/usr/lib/libvx_delegate.so.2')])
+    delegate_options = {}
+    if cache_dir:
+        cache_file = npu_cache_file(cache_dir, model_path)
+        print("Compiled graph cache", cache_file, "(hit)" if os.path.exists(cache_file) else "(miss)")
+        delegate_options = {'cache_file_path': cache_file, 'allowed_cache_mode': 'true'}
+    interpreter = tf.Interpreter(model_path=model_path, num_threads = os.cpu_count(), experimental_delegates=[tf.load_delegate(DELEGATE_PATH, delegate_options)])
     interpreter.allocate_tensors()
 
     # Get input and output tensors
@@ -32,8 +72,10 @@ def run_inference(model_path):
     # Set the tensor to point to the input data to be inferred
     interpreter.set_tensor(input_details[0]['index'], input_data)
 
-    # Run the inference
+    # Run the inference, which compiles the graph or loads it from the cache
+    start = timer()
     interpreter.invoke()
+    print("First inference: %.2f ms" % ((timer() - start) * 1000))
 
     # Get the output data
     output_data = interpreter.get_tensor(output_details[0]['index'])
@@ -42,8 +84,9 @@ def run_inference(model_path):
 if __name__ == "__main__":
     parser = argparse.ArgumentParser(description='Run inference on a TFLite model using TensorFlow Lite runtime and libvx_delegate.so')
     parser.add_argument('model_path', type=str, help='Path to the TFLite model file')
+    parser.add_argument('--cache_dir', type=str, default=None, help='Directory of the compiled graph cache of the VX delegate')
     args = parser.parse_args()
 
-    output = run_inference(args.model_path)
+    output = run_inference(args.model_path, args.cache_dir)
     print("Inference done !")
     # print("Inference results :", output_data)
\ No newline at end of file
@@ -18,7 +18,8 @@
 #include <math.h>
 #include <semaphore.h>
 #include <opencv2/opencv.hpp>
-#include "stai_mpu_network.h"
+#include "stai_mpu_wrapper.hpp"
+#include "stai_mpu_quant.h"
 #define IDENTITY_CLASSES        128
 
 #define LOG(x) std::cerr
@@ -268,10 +269,14 @@ namespace nn_postproc{
 			return -1.0;
 		}
 
+		/* When candidates is set, only the boxes of these indexes are
+		 * considered, the other scores and regressors being left unset */
 		void GetDetectedFaceLandmarks(float *classificator,
 					      float* regressors,
 					      int max_faces,
-					      Face_Results* results)
+					      Face_Results* results,
+					      const uint32_t* candidates = nullptr,
+					      size_t number_of_candidates = 0)
 		{
 			/* clear content of the previous detection */
 			results->detections.clear();
@@ -281,7 +286,9 @@ namespace nn_postproc{
 				return;
 			}
 
-			for (unsigned int i = 0; i < NUM_OF_BOXES; i++) {
+			unsigned int number_of_boxes = candidates ? number_of_candidates : NUM_OF_BOXES;
+			for (unsigned int k = 0; k < number_of_boxes; k++) {
+				unsigned int i = candidates ? candidates[k] : k;
 				float score = classificator[i];
 				score = score < -100.0f ? -100.0f : score;
 				score = score > 100.0f ? 100.0f : score;
@@ -413,7 +420,7 @@ namespace nn_postproc{
 	// This function is used to process the ouput of the model and recover relevant information such as class detected and
 	// associated accuracy. The output tensor of the model is recover through the model structure. A structure named Results
 	// is populated with theses information to be used is the application core.
-	void nn_post_proc(std::unique_ptr<stai_mpu_network>& nn_model,std::vector<stai_mpu_tensor> output_infos, inference_Results* results, BlazeFace* blaze_face)
+	void nn_post_proc(wrapper_stai_mpu::stai_mpu_wrapper& nn_model,const std::vector<stai_mpu_tensor>& output_infos, inference_Results* results, BlazeFace* blaze_face)
 	{
 
 		Face_Results blaze_face_results;
@@ -421,53 +428,62 @@ namespace nn_postproc{
 		float classificator[896];
 		float regressors[896*16];
 
-		/* Get output size */
-		std::vector<int> output_shape_0 = output_infos[0].get_shape();
+		/* Get output quantization parameters */
 		stai_mpu_quant_params qparams_output0 =  output_infos[0].get_qparams();
 		float scale_o0 = qparams_output0.static_affine.scale;
 		int zero_point_o0 = qparams_output0.static_affine.zero_point;
-		std::vector<int> output_shape_1 = output_infos[1].get_shape();
 		stai_mpu_quant_params qparams_output1 =  output_infos[1].get_qparams();
 		float scale_o1 = qparams_output1.static_affine.scale;
 		int zero_point_o1 = qparams_output1.static_affine.zero_point;
-		std::vector<int> output_shape_2 = output_infos[2].get_shape();
 		stai_mpu_quant_params qparams_output2 =  output_infos[2].get_qparams();
 		float scale_o2 = qparams_output2.static_affine.scale;
 		int zero_point_o2 = qparams_output2.static_affine.zero_point;
-		std::vector<int> output_shape_3 = output_infos[3].get_shape();
 		stai_mpu_quant_params qparams_output3 =  output_infos[3].get_qparams();
 		float scale_o3 = qparams_output3.static_affine.scale;
 		int zero_point_o3 = qparams_output3.static_affine.zero_point;
 
 		/* Get backend used */
-		results->ai_backend = nn_model->get_backend_engine();
+		results->ai_backend = nn_model.GetBackendEngine();
 
 		/* Get inference outputs */
-		uint8_t *regressors1 = static_cast<uint8_t*>(nn_model->get_output(2));
-		uint8_t *regressors2 = static_cast<uint8_t*>(nn_model->get_output(3));
-
-		int i;
-		for (i = 0; i < 512*16; i++) {
-			regressors[i] = (regressors1[i]-zero_point_o2) * scale_o2;
-		}
-		for (i = 0; i < 384; i++) {
-			regressors[i+(512*16)] = (regressors2[i]-zero_point_o3)*scale_o3;
-		}
-
-		uint8_t *classificator1 = static_cast<uint8_t*>(nn_model->get_output(0));
-		uint8_t *classificator2 = static_cast<uint8_t*>(nn_model->get_output(1));
-		int j;
-		for (j = 0; j < 512; j++) {
-				classificator[j] = (classificator1[j]-zero_point_o0)*scale_o0;
-		}
-		for (j = 0; j < 384; j++) {
-				classificator[j+512] = (classificator2[j]-zero_point_o1)*scale_o1;
+		const uint8_t *regressors1 = static_cast<const uint8_t*>(nn_model.GetOutputView(2));
+		const uint8_t *regressors2 = static_cast<const uint8_t*>(nn_model.GetOutputView(3));
+		const uint8_t *classificator1 = static_cast<const uint8_t*>(nn_model.GetOutputView(0));
+		const uint8_t *classificator2 = static_cast<const uint8_t*>(nn_model.GetOutputView(1));
+
+		/* The score threshold applies after a sigmoid: convert it in the logit
+		 * domain of the raw scores, then in their quantized domain, to find the
+		 * candidate boxes on the raw scores. The bounds are one quantization
+		 * level lower to leave the exact decision to the sigmoid of the
+		 * candidates */
+		float logit_thresh = logf(MIN_SCORE_THRESH / (1.0f - MIN_SCORE_THRESH));
+		int32_t bound_o0 = stai_mpu_quantize_threshold<uint8_t>(logit_thresh, scale_o0, zero_point_o0) - 1;
+		int32_t bound_o1 = stai_mpu_quantize_threshold<uint8_t>(logit_thresh, scale_o1, zero_point_o1) - 1;
+		uint32_t candidates[896];
+		size_t number_of_candidates = stai_mpu_find_above(classificator1, 512, bound_o0, candidates);
+		size_t number_of_candidates2 = stai_mpu_find_above(classificator2, 384, bound_o1, candidates + number_of_candidates);
+		for (size_t k = 0; k < number_of_candidates2; k++)
+			candidates[number_of_candidates + k] += 512;
+		number_of_candidates += number_of_candidates2;
+
+		/* Only dequantize the scores and regressors of the candidates */
+		for (size_t k = 0; k < number_of_candidates; k++) {
+			uint32_t i = candidates[k];
+			if (i < 512) {
+				stai_mpu_dequantize(classificator1 + i, classificator + i, 1, scale_o0, zero_point_o0);
+				stai_mpu_dequantize(regressors1 + i * 16, regressors + i * 16, 16, scale_o2, zero_point_o2);
+			} else {
+				stai_mpu_dequantize(classificator2 + (i - 512), classificator + i, 1, scale_o1, zero_point_o1);
+				stai_mpu_dequantize(regressors2 + (i - 512) * 16, regressors + i * 16, 16, scale_o3, zero_point_o3);
+			}
 		}
 
 		blaze_face->GetDetectedFaceLandmarks(classificator,
 							regressors,
 							5,
-							&blaze_face_results);
+							&blaze_face_results,
+							candidates,
+							number_of_candidates);
 
 		/* Reset the detected faces */
 		mtx.lock();
@@ -482,13 +498,6 @@ namespace nn_postproc{
 			results->detected_faces.push_back(new_face);
 		}
 		mtx.unlock();
-		/* Release memory */
-		if (results->ai_backend == stai_mpu_backend_engine::STAI_MPU_OVX_NPU_ENGINE){
-			free(regressors1);
-			free(regressors2);
-			free(classificator1);
-			free(classificator2);
-		}
 	};
 }  // namespace nn_postproc
 
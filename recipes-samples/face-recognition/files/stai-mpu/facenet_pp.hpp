@@ -20,7 +20,8 @@
 #include <iostream>
 #include <semaphore.h>
 #include <opencv2/opencv.hpp>
-#include "stai_mpu_network.h"
+#include "stai_mpu_wrapper.hpp"
+#include "stai_mpu_quant.h"
 
 #define LOG(x) std::cerr
 
@@ -89,26 +90,17 @@ namespace nn_postproc_fr{
 	// This function is used to process the ouput of the model and recover relevant information such as class detected and
 	// associated accuracy. The output tensor of the model is recover through the model structure. A structure named Results
 	// is populated with theses information to be used is the application core.
-	void nn_post_proc(std::unique_ptr<stai_mpu_network>& nn_model,std::vector<stai_mpu_tensor> output_infos, inference_Results* results)
+	void nn_post_proc(wrapper_stai_mpu::stai_mpu_wrapper& nn_model,const std::vector<stai_mpu_tensor>& output_infos, inference_Results* results)
 	{
-		/* Get output size */
-		std::vector<int> output_shape_0 = output_infos[0].get_shape();
+		/* Get output quantization parameters */
 		stai_mpu_quant_params qparams_output0 =  output_infos[0].get_qparams();
 		float scale_o0 = qparams_output0.static_affine.scale;
 		int zero_point_o0 = qparams_output0.static_affine.zero_point;
-		results->ai_backend = nn_model->get_backend_engine();
+		results->ai_backend = nn_model.GetBackendEngine();
 
 		/* Get inference outputs */
-		uint8_t *outputs = static_cast<uint8_t*>(nn_model->get_output(0));
-		int i;
-		for (i = 0; i < 512; i++) {
-			results->nn_output[i] = (outputs[i]-zero_point_o0) * scale_o0;
-		}
-
-		/* Release memory */
-		if (results->ai_backend == stai_mpu_backend_engine::STAI_MPU_OVX_NPU_ENGINE){
-			free(outputs);
-		}
+		const uint8_t *outputs = static_cast<const uint8_t*>(nn_model.GetOutputView(0));
+		stai_mpu_dequantize(outputs, results->nn_output, 512, scale_o0, zero_point_o0);
 	};
 }  // namespace nn_postproc_fr
 
@@ -51,6 +51,7 @@
 #define MAX_HISTORY_THUMBNAILS  11 /* for 720p display */
 
 #include "stai_mpu_wrapper.hpp"
+#include "stai_mpu_scheduler.h"
 #include "blazeface_pp.hpp"
 #include "facenet_pp.hpp"
 
@@ -69,7 +70,6 @@ std::string camera_src_str = "LIBCAMERA";
 
 bool verbose = false;
 bool validation = false;
-bool face_recognition_done = true;
 bool database_init = false;
 bool reco_simultaneous_face = false;
 float input_mean = 127.5f;
@@ -95,6 +95,11 @@ bool isp_first_config = true;
 #define DEFAULT_DATABASE_DIRECTORY "/usr/local/x-linux-ai/face-recognition/database/"
 #define RESOURCES_DIRECTORY "/usr/local/x-linux-ai/resources/"
 
+/* Priorities of the NN jobs on the NPU scheduler, the face detection of the
+ * live frames running before the pending face recognitions */
+#define NN_DETECTION_PRIORITY   1
+#define NN_RECOGNITION_PRIORITY 0
+
 /* Structure that contains frame size/position on the screen*/
 typedef struct _FramePosition {
 	int x;
@@ -156,9 +161,35 @@ typedef struct _Config_camera {
 	std::string main_postproc;
 } Config_camera;
 
-/* Synchronization variables */
+/* Synchronization variables: the inferences of both models are serialized by
+ * the NPU scheduler, created in main() once the arguments are parsed. The mutex
+ * only protects the faces shared between the GStreamer callbacks and the GUI */
+std::unique_ptr<stai_mpu_scheduler> npu_scheduler;
 std::mutex mtx;
 
+/* Period of the camera frames, after which a queued detection is stale */
+std::chrono::milliseconds camera_frame_period;
+
+/* Camera sample kept mapped for a detection job, unmapped and released along
+ * with the job whether the NPU scheduler ran it or dropped it */
+struct MappedSample {
+	GstSample *sample;
+	GstBuffer *buffer;
+	GstMapInfo info;
+
+	explicit MappedSample(GstSample *s) : sample(s) {
+		buffer = gst_buffer_ref(gst_sample_get_buffer(sample));
+		gst_buffer_map(buffer, &info, GST_MAP_READ);
+	}
+	~MappedSample() {
+		gst_buffer_unmap(buffer, &info);
+		gst_buffer_unref(buffer);
+		gst_sample_unref(sample);
+	}
+	MappedSample(const MappedSample&) = delete;
+	MappedSample& operator=(const MappedSample&) = delete;
+};
+
 /* Structure that contains all information to pass around */
 typedef struct _CustomData {
 	/* The gstreamer pipeline */
@@ -247,6 +278,9 @@ typedef struct _CustomData {
 	std::vector<Position> history_thumb_position[MAX_HISTORY_THUMBNAILS];
 	std::vector<RegisteredFace> registered_faces;
 	std::vector<DetectedFace> detected_faces;
+	/* Faces detected on the last live frame, waiting for their recognition */
+	std::vector<DetectedFace> pending_faces;
+	bool pending_faces_ready;
 
 	/* For validation purpose */
 	int valid_timeout_id;
@@ -458,30 +492,88 @@ gint valid_timeout_callback(gpointer data)
 }
 
 /**
- * This function execute an NN inference
+ * This function is used to process inference results and
+ * and extract class detected and accuracy
  */
-static void nn_inference(uint8_t *img)
-{;
-	stai_mpu_wrapper.RunInference(img);
-	results.inference_time = stai_mpu_wrapper.GetInferenceTime();
+static void nn_postprocessing(){
+	nn_postproc::nn_post_proc(stai_mpu_wrapper, stai_mpu_wrapper.m_output_infos, &results, &blaze_face);
 }
 
-static void nn_fr_inference(uint8_t *img)
+static void nn_fr_postprocessing(){
+	nn_postproc_fr::nn_post_proc(stai_mpu_wrapper_fr, stai_mpu_wrapper_fr.m_output_infos, &results_fr);
+}
+
+/**
+ * This function queue an NN inference and its post-processing on the NPU
+ * scheduler, and return without waiting for it. The image must stay valid until
+ * the job is done or dropped, the job being dropped when the deadline passed
+ * before it could start. The on_results callback, if any, is called by the job
+ * once the results are post-processed.
+ */
+static std::future<stai_mpu_job_status> nn_inference(const uint8_t *img, size_t row_stride = 0,
+						     stai_mpu_scheduler::clock::time_point deadline = stai_mpu_scheduler::clock::time_point::max(),
+						     std::function<void()> on_results = nullptr)
 {
-	stai_mpu_wrapper_fr.RunInference(img);
-	results_fr.inference_time = stai_mpu_wrapper_fr.GetInferenceTime();
+	return npu_scheduler->submit([=]() {
+		stai_mpu_wrapper.RunInference(img, row_stride);
+		results.inference_time = stai_mpu_wrapper.GetInferenceTime();
+		nn_postprocessing();
+		if (on_results)
+			on_results();
+		return true;
+	}, NN_DETECTION_PRIORITY, deadline);
 }
 
 /**
- * This function is used to process inference results and
- * and extract class detected and accuracy
+ * This function queue the face recognition NN inference of one face on the NPU
+ * scheduler, and return without waiting for it. The job post-processes the
+ * outputs, shared with the other face recognition jobs, copies the identity of
+ * the face and adds its inference time to inference_time, if any. The image
+ * must stay valid and the identity must not be read until the job is done.
  */
-static void nn_postprocessing(){
-	nn_postproc::nn_post_proc(stai_mpu_wrapper.m_stai_mpu_model, stai_mpu_wrapper.m_output_infos, &results, &blaze_face);
+static std::future<stai_mpu_job_status> nn_fr_inference(const uint8_t *img, float *identity,
+							float *inference_time = nullptr)
+{
+	return npu_scheduler->submit([=]() {
+		stai_mpu_wrapper_fr.RunInference(img);
+		results_fr.inference_time = stai_mpu_wrapper_fr.GetInferenceTime();
+		if (inference_time)
+			*inference_time += results_fr.inference_time;
+		nn_fr_postprocessing();
+		std::copy(std::begin(results_fr.nn_output), std::end(results_fr.nn_output), identity);
+		return true;
+	}, NN_RECOGNITION_PRIORITY);
 }
 
-static void nn_fr_postprocessing(){
-	nn_postproc_fr::nn_post_proc(stai_mpu_wrapper_fr.m_stai_mpu_model, stai_mpu_wrapper_fr.m_output_infos, &results_fr);
+/**
+ * This function wait for the face recognition jobs queued for the faces of a
+ * frame
+ */
+static void nn_fr_wait(std::vector<std::future<stai_mpu_job_status>>& jobs)
+{
+	for (uint32_t i = 0 ; i < jobs.size() ; i++)
+		jobs[i].get();
+	jobs.clear();
+}
+
+/**
+ * This function label the faces with the closest registered identity
+ */
+static void nn_fr_match_faces(std::vector<DetectedFace>& faces, CustomData *data)
+{
+	for (uint32_t i = 0 ; i < faces.size() ; i++) {
+		for (unsigned int j = 0 ; j < data->registered_faces.size() ; j++) {
+			float similarity = nn_postproc_fr::cosine_similarity(faces[i].identity, data->registered_faces[j].identity, FACE_IDENTITY_CLASSES);
+			if(similarity <= reco_threshold){
+				faces[i].label =  data->registered_faces[j].label;
+				faces[i].similarity = similarity;
+				break;
+			} else {
+				faces[i].label = "unknown";
+				faces[i].similarity = similarity;
+			}
+		}
+	}
 }
 
 static int load_valid_results_from_json_file(std::string file_name, std::vector<ValidFaceInfo> *faces_info)
@@ -539,6 +631,13 @@ static void register_new_face_from_file(std::string dir,
 	new_face.label.erase(0, dir.length());
 	new_face.label.erase(new_face.label.find("."));
 	face_bgr = cv::imread(new_face.file_path);
+
+	/* Queue the inference, the thumbnail being built while it runs */
+	cv::Size size_nn(data->nn_fr_input_width,data->nn_fr_input_height);
+	cv::resize(face_bgr, img_nn, size_nn);
+	cv::cvtColor(img_nn, img_nn, cv::COLOR_BGR2RGB);
+	std::future<stai_mpu_job_status> job = nn_fr_inference(img_nn.data, new_face.identity);
+
 	cv::cvtColor(face_bgr, face_bgra, cv::COLOR_BGR2BGRA);
 
 	cv::Size size(data->ui_face_thumb_size, data->ui_face_thumb_size);
@@ -552,14 +651,10 @@ static void register_new_face_from_file(std::string dir,
 						    data->ui_face_thumb_size,
 						    stride);
 
-	cv::Size size_nn(data->nn_fr_input_width,data->nn_fr_input_height);
-	cv::resize(face_bgr, img_nn, size_nn);
-	cv::cvtColor(img_nn, img_nn, cv::COLOR_BGR2RGB);
-
-	nn_fr_inference(img_nn.data);
-	nn_fr_postprocessing();
-	std::copy(std::begin(results_fr.nn_output), std::end(results_fr.nn_output), std::begin(new_face.identity));
+	job.get();
+	mtx.lock();
 	data->registered_faces.push_back(new_face);
+	mtx.unlock();
 }
 
 /**
@@ -748,6 +843,14 @@ static gboolean infer_new_picture(CustomData *data)
 		cv::Mat img_bgr, img_bgra, img_tdp, img_nn, cropped_frame;
 
 		img_bgr = cv::imread(data->file);
+
+		/* Queue the inference, the frame to display being prepared while
+		 * it runs */
+		cv::Size size_nn(data->nn_input_width, data->nn_input_height);
+		cv::resize(img_bgr, img_nn, size_nn);
+		cv::cvtColor(img_nn, img_nn, cv::COLOR_BGR2RGB);
+		std::future<stai_mpu_job_status> detection = nn_inference(img_nn.data);
+
 		cv::cvtColor(img_bgr, img_bgra, cv::COLOR_BGR2BGRA);
 		data->frame_width =  img_bgra.size().width;
 		data->frame_height = img_bgra.size().height;
@@ -758,13 +861,7 @@ static gboolean infer_new_picture(CustomData *data)
 		cv::resize(img_bgra, img_tdp , size);
 		data->img_to_display = img_tdp.clone();
 
-		/* prepare the inference */
-		cv::Size size_nn(data->nn_input_width, data->nn_input_height);
-		cv::resize(img_bgr, img_nn, size_nn);
-		cv::cvtColor(img_nn, img_nn, cv::COLOR_BGR2RGB);
-
-		nn_inference(img_nn.data);
-		nn_postprocessing();
+		detection.get();
 		data->detected_faces.clear();
 		if (reco_simultaneous_face){
 			for (uint32_t i = 0 ; i < results.detected_faces.size() ; i ++) {
@@ -792,7 +889,10 @@ static gboolean infer_new_picture(CustomData *data)
 			}
 		}
 		if(!data->detected_faces.empty()) {
-			data->total_face_reco_inference_time = 0;
+			/* Each face is queued for recognition once cropped, the next
+			 * one being cropped while it runs */
+			std::vector<std::future<stai_mpu_job_status>> jobs;
+			float inference_time = 0;
 			for (uint32_t i = 0 ; i < data->detected_faces.size() ; i++) {
 				float face_x0 = data->frame_disp_pos.width  * data->detected_faces[i].bbox.top_left.x;
 				float face_y0 = data->frame_disp_pos.height * data->detected_faces[i].bbox.top_left.y;
@@ -805,22 +905,13 @@ static gboolean infer_new_picture(CustomData *data)
 				cv::resize(cropped_frame,cropped_frame,cv::Size(160,160));
 				cv::cvtColor(cropped_frame, cropped_frame, cv::COLOR_BGR2RGB);
 				data->detected_faces[i].face_rgb = cropped_frame.clone();
-				nn_fr_inference(data->detected_faces[i].face_rgb.data);
-				nn_fr_postprocessing();
-				std::copy(std::begin(results_fr.nn_output), std::end(results_fr.nn_output), std::begin(data->detected_faces[i].identity));
-				data->total_face_reco_inference_time += results_fr.inference_time;
-				for (unsigned int j = 0 ; j < data->registered_faces.size() ; j++) {
-					float similarity = nn_postproc_fr::cosine_similarity(data->detected_faces[i].identity, data->registered_faces[j].identity, FACE_IDENTITY_CLASSES);
-					if(similarity <= reco_threshold){
-						data->detected_faces[i].label =  data->registered_faces[j].label;
-						data->detected_faces[i].similarity = similarity;
-						break;
-					} else {
-						data->detected_faces[i].label = "unknown";
-						data->detected_faces[i].similarity = similarity;
-					}
-				}
+				jobs.push_back(nn_fr_inference(data->detected_faces[i].face_rgb.data,
+							       data->detected_faces[i].identity,
+							       &inference_time));
 			}
+			nn_fr_wait(jobs);
+			data->total_face_reco_inference_time = inference_time;
+			nn_fr_match_faces(data->detected_faces, data);
 		}
 
 		/* Updating the information with the new inference results */
@@ -966,11 +1057,13 @@ void gui_display_outlined_text(cairo_t *cr,
 static void gui_delete_registered_face(int i,
 				       CustomData *data)
 {
+	mtx.lock();
 	unsigned int index = data->registered_faces.size() - i - 1;
 	/* delete the registered face */
 	cairo_surface_destroy(data->registered_faces[index].cairo_s_face);
 	remove(const_cast<char*>(data->registered_faces[index].file_path.c_str()));
 	data->registered_faces.erase(data->registered_faces.begin() + index);
+	mtx.unlock();
 }
 
 /**
@@ -1963,38 +2056,22 @@ static void gui_create_keyboard(CustomData *data)
 }
 
 /**
- * This function is called to preprocess each camera buffer before NN inference
+ * This function is called to get the row stride of each camera buffer before NN inference
  */
-std::vector<uint8_t> gst_preprocess_buffer(GstMapInfo& info, int width, int height, int nnInputWidth) {
+size_t gst_buffer_row_stride(int width, int nnInputWidth) {
 	/*DCMIPP pixelpacker has a constraint on the output resolution that should be multiple of 16.
     the allocated buffer may contains stride to handle the DCMIPP Hw constraints/
     The following code allow to handle both cases by anticipating the size of the
     allocated buffer according to the NN resolution
 	*/
 	int channels = 3;
-	int stride, offset;
 
 	//Calculate the nearest upper multiple of 16
 	if (nnInputWidth % 16 != 0) {
 		int upperMultiple = ((nnInputWidth / 16) + 1) * 16;
-		//Calculate the stride and offset
-		stride = upperMultiple * channels;
-		offset = stride - (width * channels);
-	} else {
-		//Calculate the stride and offset
-		stride = width * channels;
-		offset = 0;
-	}
-
-	int numLines = info.size / stride;
-	std::vector<uint8_t> preprocessedData;
-	//fill the processed buffer properly depending on stride and offset
-	for (int i = 0; i < numLines; ++i) {
-		int startIndex = i * stride;
-		int endIndex = startIndex + (stride - offset);
-		preprocessedData.insert(preprocessedData.end(), info.data + startIndex, info.data + endIndex);
+		return upperMultiple * channels;
 	}
-	return preprocessedData;
+	return width * channels;
 }
 
 /**
@@ -2002,83 +2079,62 @@ std::vector<uint8_t> gst_preprocess_buffer(GstMapInfo& info, int width, int heig
  */
 static GstFlowReturn  gst_new_sample_cb(GstElement *sink, CustomData *data)
 {
+	GstSample *sample;
 	/* Retrieve the buffer */
-	if (face_recognition_done) {
-		GstSample *sample;
-		GstBuffer *app_buffer, *buffer;
-		GstMapInfo info;
-		g_signal_emit_by_name (sink, "pull-sample", &sample);
-		if (sample) {
-			/* Recover information of the GST sample */
-			GstCaps* caps = gst_sample_get_caps(sample);
-			GstStructure* structure = gst_caps_get_structure(caps, 0);
-			int width, height;
-			gst_structure_get_int(structure, "width", &width);
-			gst_structure_get_int(structure, "height", &height);
-			buffer = gst_sample_get_buffer (sample);
-
-			buffer = gst_sample_get_buffer (sample);
-
-			/* Make a copy */
-			app_buffer = gst_buffer_ref (buffer);
-
-			gst_buffer_map(app_buffer, &info, GST_MAP_READ);
-
-			#ifdef DEBUG
-				FILE *file = fopen("NN_sample_dump.raw", "wb");
-				if (file != NULL) {
-					fwrite(info.data, info.size, 1, file);
-					fclose(file);
-					int ret = GST_FLOW_OK;
-				}
-			#endif
-
-			/* Execute the inference */
-			mtx.lock();
-			/* Preprocess the camera buffer */
-			std::vector<uint8_t> nn_input_sample;
-			nn_input_sample = gst_preprocess_buffer(info,width,height,data->nn_input_width);
-			/* Execute the inference */
-			nn_inference(nn_input_sample.data());
-			nn_postprocessing();
-			data->detected_faces.clear();
-			if (reco_simultaneous_face){
-				for (uint32_t i = 0 ; i < results.detected_faces.size() ; i ++) {
-					DetectedFace new_face;
-					Bbox bbox;
-					bbox.top_left.x = results.detected_faces[i].landmarks.face.x0;
-					bbox.top_left.y = results.detected_faces[i].landmarks.face.y0;
-					bbox.bot_right.x = results.detected_faces[i].landmarks.face.x1;
-					bbox.bot_right.y = results.detected_faces[i].landmarks.face.y1;
-					new_face.label = "unknown";
-					new_face.bbox = bbox;
-					data->detected_faces.push_back(new_face);
-				}
-			} else {
-				if (!results.detected_faces.empty()){
-					DetectedFace new_face;
-					Bbox bbox;
-					bbox.top_left.x = results.detected_faces[0].landmarks.face.x0;
-					bbox.top_left.y = results.detected_faces[0].landmarks.face.y0;
-					bbox.bot_right.x = results.detected_faces[0].landmarks.face.x1;
-					bbox.bot_right.y = results.detected_faces[0].landmarks.face.y1;
-					new_face.label = "unknown";
-					new_face.bbox = bbox;
-					data->detected_faces.push_back(new_face);
-				}
+	g_signal_emit_by_name (sink, "pull-sample", &sample);
+	if (sample) {
+		/* Recover information of the GST sample */
+		GstCaps* caps = gst_sample_get_caps(sample);
+		GstStructure* structure = gst_caps_get_structure(caps, 0);
+		int width, height;
+		gst_structure_get_int(structure, "width", &width);
+		gst_structure_get_int(structure, "height", &height);
+
+		/* Keep the sample mapped until its inference job is done or
+		 * dropped */
+		std::shared_ptr<MappedSample> frame = std::make_shared<MappedSample>(sample);
+
+		#ifdef DEBUG
+			FILE *file = fopen("NN_sample_dump.raw", "wb");
+			if (file != NULL) {
+				fwrite(frame->info.data, frame->info.size, 1, file);
+				fclose(file);
+				int ret = GST_FLOW_OK;
 			}
-			face_recognition_done = false;
-			gst_buffer_unmap(app_buffer, &info);
-			gst_buffer_unref(app_buffer);
-
-			/* We don't need the appsink sample anymore */
-			gst_sample_unref (sample);
-			return GST_FLOW_OK;
-		} else {
-			return GST_FLOW_ERROR;
-		}
-	} else {
+		#endif
+
+		/* Queue the inference, the rows of the camera buffer being
+		 * gathered into the NN input according to their stride, and
+		 * return to the pipeline while it runs. A frame still waiting
+		 * for the NPU when the next one is captured is stale and
+		 * dropped */
+		nn_inference(frame->info.data, gst_buffer_row_stride(width, data->nn_input_width),
+			     stai_mpu_scheduler::clock::now() + camera_frame_period,
+			     [frame, data]() {
+			std::vector<DetectedFace> faces;
+			uint32_t nb_faces = reco_simultaneous_face ? results.detected_faces.size() :
+				std::min<uint32_t>(1, results.detected_faces.size());
+			for (uint32_t i = 0 ; i < nb_faces ; i ++) {
+				DetectedFace new_face;
+				Bbox bbox;
+				bbox.top_left.x = results.detected_faces[i].landmarks.face.x0;
+				bbox.top_left.y = results.detected_faces[i].landmarks.face.y0;
+				bbox.bot_right.x = results.detected_faces[i].landmarks.face.x1;
+				bbox.bot_right.y = results.detected_faces[i].landmarks.face.y1;
+				new_face.label = "unknown";
+				new_face.bbox = bbox;
+				faces.push_back(new_face);
+			}
+			/* Hand the faces over to the recognition, replacing the ones
+			 * of an older frame not recognized yet */
+			mtx.lock();
+			data->pending_faces = std::move(faces);
+			data->pending_faces_ready = true;
+			mtx.unlock();
+		});
 		return GST_FLOW_OK;
+	} else {
+		return GST_FLOW_ERROR;
 	}
 }
 
@@ -2087,79 +2143,88 @@ static GstFlowReturn  gst_new_sample_cb(GstElement *sink, CustomData *data)
  */
 static GstFlowReturn gst_new_sample_fr_cb(GstElement *sink, CustomData *data)
 {
-	if(!face_recognition_done) {
-		GstSample *sample;
-		GstBuffer *app_buffer, *buffer;
-		GstMapInfo info;
-		/* Retrieve the buffer */
-		g_signal_emit_by_name (sink, "pull-sample", &sample);
-		if (sample) {
-			buffer = gst_sample_get_buffer (sample);
-
-			/* Make a copy */
-			app_buffer = gst_buffer_ref (buffer);
-
-			gst_buffer_map(app_buffer, &info, GST_MAP_READ);
-
-			#ifdef DEBUG
-				FILE *file = fopen("NN_sample_dump_fr.raw", "wb");
-				if (file != NULL) {
-					fwrite(info.data, info.size, 1, file);
-					fclose(file);
-					int ret = GST_FLOW_OK;
-				}
-			#endif
+	GstSample *sample;
+	GstBuffer *app_buffer, *buffer;
+	GstMapInfo info;
+	/* Retrieve the buffer */
+	g_signal_emit_by_name (sink, "pull-sample", &sample);
+	if (sample) {
+		/* Take the faces of the last detection, if any */
+		std::vector<DetectedFace> faces;
+		mtx.lock();
+		bool faces_ready = data->pending_faces_ready;
+		if (faces_ready) {
+			faces = std::move(data->pending_faces);
+			data->pending_faces.clear();
+			data->pending_faces_ready = false;
+		}
+		mtx.unlock();
+		if (!faces_ready) {
+			gst_sample_unref (sample);
+			return GST_FLOW_OK;
+		}
 
-			int width = data->window_width;
-			int height = data->window_height;
-			int channels = 3;
-			cv::Mat frame(height, width, CV_8UC3, info.data);
-			cv::Mat cropped_frame;
+		buffer = gst_sample_get_buffer (sample);
 
-			data->total_face_reco_inference_time = 0;
-			for (uint32_t i = 0 ; i < data->detected_faces.size() ; i++) {
-				float face_x0 = width  * data->detected_faces[i].bbox.top_left.x;
-				float face_y0 = height * data->detected_faces[i].bbox.top_left.y;
-				float face_x1 = width  * data->detected_faces[i].bbox.bot_right.x;
-				float face_y1 = height * data->detected_faces[i].bbox.bot_right.y;
-				float width_box = width  * (data->detected_faces[i].bbox.bot_right.x - data->detected_faces[i].bbox.top_left.x);
-				float height_box =  height *(data->detected_faces[i].bbox.bot_right.y - data->detected_faces[i].bbox.top_left.y);
-				cv::Rect crop_region(face_x0, face_y0, width_box, height_box);
-				cropped_frame = frame(crop_region);
-				cv::resize(cropped_frame,cropped_frame,cv::Size(160,160));
-				data->detected_faces[i].face_rgb = cropped_frame.clone();
-				nn_fr_inference(data->detected_faces[i].face_rgb.data);
-				nn_fr_postprocessing();
-				data->total_face_reco_inference_time += results_fr.inference_time;
-				std::copy(std::begin(results_fr.nn_output), std::end(results_fr.nn_output), std::begin(data->detected_faces[i].identity));
-				for (unsigned int j = 0 ; j < data->registered_faces.size() ; j++) {
-					float similarity = nn_postproc_fr::cosine_similarity(data->detected_faces[i].identity, data->registered_faces[j].identity, FACE_IDENTITY_CLASSES);
-					if(similarity <= reco_threshold){
-						data->detected_faces[i].label =  data->registered_faces[j].label;
-						data->detected_faces[i].similarity = similarity;
-						break;
-					} else {
-						data->detected_faces[i].label = "unknown";
-						data->detected_faces[i].similarity = similarity;
-					}
-				}
+		/* Make a copy */
+		app_buffer = gst_buffer_ref (buffer);
+
+		gst_buffer_map(app_buffer, &info, GST_MAP_READ);
+
+		#ifdef DEBUG
+			FILE *file = fopen("NN_sample_dump_fr.raw", "wb");
+			if (file != NULL) {
+				fwrite(info.data, info.size, 1, file);
+				fclose(file);
+				int ret = GST_FLOW_OK;
 			}
-			face_recognition_done = true;
-			mtx.unlock();
-			gst_buffer_unmap(app_buffer, &info);
-			gst_buffer_unref(app_buffer);
-			/* We don't need the appsink sample anymore */
-			gst_sample_unref (sample);
-			/* Call application callback only in playing state */
-			gst_element_post_message(sink,
-						gst_message_new_application(GST_OBJECT(sink),
-						gst_structure_new_empty("inference-done")));
-			return GST_FLOW_OK;
-		} else {
-			return GST_FLOW_ERROR;
+		#endif
+
+		int width = data->window_width;
+		int height = data->window_height;
+		cv::Mat frame(height, width, CV_8UC3, info.data);
+		cv::Mat cropped_frame;
+
+		/* Each face is queued for recognition once cropped, the next one
+		 * being cropped while it runs. The faces are cloned out of the
+		 * buffer, which is released before waiting for the jobs */
+		std::vector<std::future<stai_mpu_job_status>> jobs;
+		float inference_time = 0;
+		for (uint32_t i = 0 ; i < faces.size() ; i++) {
+			float face_x0 = width  * faces[i].bbox.top_left.x;
+			float face_y0 = height * faces[i].bbox.top_left.y;
+			float width_box = width  * (faces[i].bbox.bot_right.x - faces[i].bbox.top_left.x);
+			float height_box =  height *(faces[i].bbox.bot_right.y - faces[i].bbox.top_left.y);
+			cv::Rect crop_region(face_x0, face_y0, width_box, height_box);
+			cropped_frame = frame(crop_region);
+			cv::resize(cropped_frame,cropped_frame,cv::Size(160,160));
+			faces[i].face_rgb = cropped_frame.clone();
+			jobs.push_back(nn_fr_inference(faces[i].face_rgb.data, faces[i].identity,
+						       &inference_time));
 		}
-	} else {
+		gst_buffer_unmap(app_buffer, &info);
+		gst_buffer_unref(app_buffer);
+		/* We don't need the appsink sample anymore */
+		gst_sample_unref (sample);
+
+		if (!faces.empty()) {
+			nn_fr_wait(jobs);
+			data->total_face_reco_inference_time = inference_time;
+		}
+
+		/* Publish the recognized faces to the GUI */
+		mtx.lock();
+		nn_fr_match_faces(faces, data);
+		data->detected_faces = std::move(faces);
+		mtx.unlock();
+
+		/* Call application callback only in playing state */
+		gst_element_post_message(sink,
+					gst_message_new_application(GST_OBJECT(sink),
+					gst_structure_new_empty("inference-done")));
 		return GST_FLOW_OK;
+	} else {
+		return GST_FLOW_ERROR;
 	}
 }
 
@@ -2572,12 +2637,10 @@ int main(int argc, char *argv[])
 	/* Process the application parameters */
 	process_args(argc, argv);
 
-	/* Get number of CPU cores available */
-	uint8_t nb_cpu_cores = 1;
-	const auto processor_count = std::thread::hardware_concurrency();
-	std::cout << processor_count << " cpu core(s) available\n";
-	if (processor_count)
-		nb_cpu_cores = (uint8_t)processor_count;
+	/* Start the NPU scheduler and compute the camera frame period, once
+	 * the parameters are known */
+	npu_scheduler.reset(new stai_mpu_scheduler());
+	camera_frame_period = std::chrono::milliseconds(1000 / std::max(1, std::stoi(camera_fps_str)));
 
 	/* Initialize our data structure */
 	data.pipeline = NULL;
@@ -2592,6 +2655,7 @@ int main(int argc, char *argv[])
 	data.ui_weston_panel_thickness = 32;
 	data.max_db_faces = max_db_faces;
 	data.total_face_reco_inference_time = 0;
+	data.pending_faces_ready = false;
 
 	if (database_dir_str.empty())
 		database_dir_str = DEFAULT_DATABASE_DIRECTORY;
@@ -2601,7 +2665,6 @@ int main(int argc, char *argv[])
 	config.model_name = model_file_str;
 	config.input_mean = input_mean;
 	config.input_std = input_std;
-	config.number_of_threads = nb_cpu_cores;
 
 	stai_mpu_wrapper.Initialize(&config);
 
@@ -2610,7 +2673,6 @@ int main(int argc, char *argv[])
 	config_fr.model_name = model_file_fr_str;
 	config_fr.input_mean = input_mean;
 	config_fr.input_std = input_std;
-	config_fr.number_of_threads = nb_cpu_cores;
 
 	stai_mpu_wrapper_fr.Initialize(&config_fr);
 
@@ -2714,6 +2776,9 @@ int main(int argc, char *argv[])
 		g_print("Deleting Gst pipeline\n");
 		gst_object_unref(data.pipeline);
 	}
+	/* Stop the NPU scheduler, dropping the jobs still queued, before the
+	 * models are released */
+	npu_scheduler.reset();
 	g_print(" Application exited properly \n");
 	return 0;
 }
@@ -15,7 +15,7 @@
 #include <string>
 #include <vector>
 #include <fstream>
-#include "stai_mpu_network.h"
+#include "stai_mpu_wrapper.hpp"
 
 #define LOG(x) std::cerr
 
@@ -29,41 +29,49 @@ namespace nn_postproc{
 		float inference_time;
 	};
 
+	// Find the indexes of the 5 highest values of the output without modifying
+	// it, as the output view is shared with the runtime.
+	template <typename T>
+	void Top5(const T* output_data, unsigned int output_size, Label_Results* results)
+	{
+		for (int i = 0; i < 5; i++) {
+			int best = -1;
+			for (unsigned int j = 0; j < output_size; j++) {
+				if (std::find(results->index, results->index + i, (int)j) != results->index + i)
+					continue;
+				if (best < 0 || output_data[j] > output_data[best])
+					best = j;
+			}
+			results->index[i] = best;
+		}
+	};
+
 	// This function is used to process the ouput of the model and recover relevant information such as class detected and
 	// associated accuracy. The output tensor of the model is recover through the model structure. A structure named Results
 	// is populated with theses information to be used is the application core.
-	void nn_post_proc(std::unique_ptr<stai_mpu_network>& nn_model,std::vector<stai_mpu_tensor> output_infos, Label_Results* results)
+	void nn_post_proc(wrapper_stai_mpu::stai_mpu_wrapper& nn_model,const std::vector<stai_mpu_tensor>& output_infos, Label_Results* results)
 	{
-		void* outputs_tensor = nn_model->get_output(0);
+		const void* outputs_tensor = nn_model.GetOutputView(0);
 		int output_dims = output_infos[0].get_rank();
 		stai_mpu_dtype output_dtype = output_infos[0].get_dtype();
-		stai_mpu_backend_engine stai_backend = nn_model->get_backend_engine();
 
 		/* Get output shape */
-		std::vector<int> output_shape = output_infos[0].get_shape();
+		const std::vector<int>& output_shape = output_infos[0].get_shape();
 
 		/* Get output size */
 		unsigned int output_size  = output_shape[output_dims-1];
 
 		/* Process output data depending on the date type FLOAT32/16 or UINT8/INT8 */
 		if (output_dtype == stai_mpu_dtype::STAI_MPU_DTYPE_FLOAT32 || output_dtype == stai_mpu_dtype::STAI_MPU_DTYPE_FLOAT16) {
-			float* output_data = static_cast<float*>(outputs_tensor);
-			for (int i = 0; i < 5; i++) {
-				results->index[i] = std::distance(&output_data[0], std::max_element(&output_data[0], &output_data[output_size]));
+			const float* output_data = static_cast<const float*>(outputs_tensor);
+			Top5(output_data, output_size, results);
+			for (int i = 0; i < 5; i++)
 				results->accuracy[i] = output_data[results->index[i]];
-				output_data[results->index[i]] = 0;
-			}
 		} else {
-			uint8_t* output_data = static_cast<uint8_t*>(outputs_tensor);
-			for (int i = 0; i < 5; i++) {
-				results->index[i] = std::distance(&output_data[0], std::max_element(&output_data[0], &output_data[output_size]));
+			const uint8_t* output_data = static_cast<const uint8_t*>(outputs_tensor);
+			Top5(output_data, output_size, results);
+			for (int i = 0; i < 5; i++)
 				results->accuracy[i] = output_data[results->index[i]] / 255.0;
-				output_data[results->index[i]] = 0;
-			}
-		}
-		/* Release the output vector to avoid memory leak issues */
-		if (stai_backend == stai_mpu_backend_engine::STAI_MPU_OVX_NPU_ENGINE){
-			free(outputs_tensor);
 		}
 	};
 
@@ -319,9 +319,9 @@ gint valid_timeout_callback(gpointer data)
 /**
  * This function execute an NN inference
  */
-static void nn_inference(uint8_t *img)
+static void nn_inference(uint8_t *img, size_t row_stride = 0)
 {
-	stai_mpu_wrapper.RunInference(img);
+	stai_mpu_wrapper.RunInference(img, row_stride);
 	results.inference_time = stai_mpu_wrapper.GetInferenceTime();
 }
 
@@ -330,7 +330,7 @@ static void nn_inference(uint8_t *img)
  * and extract class detected and accuracy
  */
 static void nn_postprocessing(){
-	nn_postproc::nn_post_proc(stai_mpu_wrapper.m_stai_mpu_model, stai_mpu_wrapper.m_output_infos, &results);
+	nn_postproc::nn_post_proc(stai_mpu_wrapper, stai_mpu_wrapper.m_output_infos, &results);
 }
 
 /**
@@ -1069,38 +1069,22 @@ static void gui_create_main(CustomData *data)
 }
 
 /**
- * This function is called to preprocess each camera buffer before NN inference
+ * This function is called to get the row stride of each camera buffer before NN inference
  */
-std::vector<uint8_t> gst_preprocess_buffer(GstMapInfo& info, int width, int height, int nnInputWidth) {
+size_t gst_buffer_row_stride(int width, int nnInputWidth) {
 	/*DCMIPP pixelpacker has a constraint on the output resolution that should be multiple of 16.
     the allocated buffer may contains stride to handle the DCMIPP Hw constraints/
     The following code allow to handle both cases by anticipating the size of the
     allocated buffer according to the NN resolution
 	*/
 	int channels = 3;
-	int stride, offset;
 
 	//Calculate the nearest upper multiple of 16
 	if (nnInputWidth % 16 != 0) {
 		int upperMultiple = ((nnInputWidth / 16) + 1) * 16;
-		//Calculate the stride and offset
-		stride = upperMultiple * channels;
-		offset = stride - (width * channels);
-	} else {
-		//Calculate the stride and offset
-		stride = width * channels;
-		offset = 0;
-	}
-
-	int numLines = info.size / stride;
-	std::vector<uint8_t> preprocessedData;
-	//fill the processed buffer properly depending on stride and offset
-	for (int i = 0; i < numLines; ++i) {
-		int startIndex = i * stride;
-		int endIndex = startIndex + (stride - offset);
-		preprocessedData.insert(preprocessedData.end(), info.data + startIndex, info.data + endIndex);
+		return upperMultiple * channels;
 	}
-	return preprocessedData;
+	return width * channels;
 }
 
 /**
@@ -1139,11 +1123,9 @@ static GstFlowReturn gst_new_sample_cb(GstElement *sink, CustomData *data)
 		#endif
 
 		if(camera_src_str == "LIBCAMERA"){
-			/* Preprocess the camera buffer */
-			std::vector<uint8_t> nn_input_sample;
-			nn_input_sample = gst_preprocess_buffer(info,width,height,data->nn_input_width);
-			/* Execute the inference */
-			nn_inference(nn_input_sample.data());
+			/* Execute the inference, the rows of the camera buffer being
+			 * gathered into the NN input according to their stride */
+			nn_inference(info.data, gst_buffer_row_stride(width, data->nn_input_width));
 		} else {
 			/* Execute the inference */
 			nn_inference(info.data);
@@ -1643,13 +1625,6 @@ int main(int argc, char *argv[])
 	/* Process the application parameters */
 	process_args(argc, argv);
 
-	/* Get number of CPU cores available */
-	uint8_t nb_cpu_cores = 1;
-	const auto processor_count = std::thread::hardware_concurrency();
-	std::cout << processor_count << " cpu core(s) available\n";
-	if (processor_count)
-		nb_cpu_cores = (uint8_t)processor_count;
-
 	/* Initialize our data structure */
 	data.pipeline = NULL;
 	data.pipeline_nn = NULL;
@@ -1669,7 +1644,6 @@ int main(int argc, char *argv[])
 	config.labels_file_name = labels_file_str;
 	config.input_mean = input_mean;
 	config.input_std = input_std;
-	config.number_of_threads = nb_cpu_cores;
 	config.number_of_results = 5;
 
 	stai_mpu_wrapper.Initialize(&config);
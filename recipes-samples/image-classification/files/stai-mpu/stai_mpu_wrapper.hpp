@@ -12,26 +12,28 @@
 #define stai_mpu_WRAPPER_HPP_
 
 #include <algorithm>
+#include <cstring>
 #include <functional>
 #include <queue>
 #include <memory>
 #include <string>
-#include <sys/time.h>
 #include <vector>
 #include <fstream>
 
 #include "stai_mpu_network.h"
+#include "stai_mpu_runner.h"
+#include "stai_mpu_preprocess.h"
 
 #define LOG(x) std::cerr
 
 namespace wrapper_stai_mpu{
 
-	double get_ms(struct timeval t) { return (t.tv_sec * 1000 + t.tv_usec / 1000); }
 	struct Config {
 		bool verbose;
 		float input_mean = 127.5f;
 		float input_std = 127.5f;
-		int number_of_threads = 2;
+		uint64_t cpu_affinity_mask = 0;
+		int warmup_iterations = 1;
 		int number_of_results = 5;
 		std::string model_name;
 		std::string labels_file_name;
@@ -41,14 +43,13 @@ namespace wrapper_stai_mpu{
 		private:
 			std::vector<stai_mpu_tensor>                     m_input_infos;
 			std::vector<int> 							 m_input_shape;
-			std::vector<int> 							 m_output_shape;
-			uint8_t* 									 m_input_tensor_int;
-			float* 										 m_input_tensor_f;
+			std::unique_ptr<stai_mpu_preprocessor>		 m_preprocessor;
+			std::vector<uint8_t>						 m_input_tensor;
 			bool                                     	 m_verbose;
 			bool                                     	 m_allow_fp16;
 			float                                   	 m_inputMean;
 			float                                  	 	 m_inputStd;
-			int                                      	 m_numberOfThreads;
+			uint64_t									 m_cpuAffinityMask;
 			int                                      	 m_numberOfResults;
 			int 										 m_num_inputs;
 			int 										 m_num_outputs;
@@ -56,10 +57,11 @@ namespace wrapper_stai_mpu{
 			int 										 m_input_height;
 			int 										 m_input_channels;
 			int											 m_sizeInBytes;
-			float                                   	 m_inferenceTime;
 
 		public:
 			std::unique_ptr<stai_mpu_network>             	 m_stai_mpu_model;
+			/* Declared after the model so that it is destroyed before it */
+			std::unique_ptr<stai_mpu_runner>				 m_runner;
 			std::vector<stai_mpu_tensor>					 m_output_infos;
 
 			stai_mpu_wrapper() {}
@@ -68,11 +70,10 @@ namespace wrapper_stai_mpu{
 		void Initialize(Config* conf)
 		{
 			m_allow_fp16 = false;
-			m_inferenceTime = 0;
 			m_verbose = conf->verbose;
 			m_inputMean = conf->input_mean;
 			m_inputStd = conf->input_std;
-			m_numberOfThreads = conf->number_of_threads;
+			m_cpuAffinityMask = conf->cpu_affinity_mask;
 			m_numberOfResults = conf->number_of_results;
 
 			if (!conf->model_name.c_str()) {
@@ -81,13 +82,21 @@ namespace wrapper_stai_mpu{
 			}
 
 			std::string model_path = conf->model_name.c_str();
+			stai_mpu_network_options options;
+			stai_mpu_startup_stats startup_stats;
+			options.cpu_affinity_mask = m_cpuAffinityMask;
+			/* Warm the model up at load time so that the first frame does not
+			 * pay for the initializations deferred to the first run */
+			options.warmup_iterations = conf->warmup_iterations;
+			options.startup_stats = &startup_stats;
 			size_t dot_pos = model_path.find_last_of('.');
 			// Depending on model extension enable or not hardware acceleration
 			if (model_path.substr(dot_pos) == ".nb"){
-				m_stai_mpu_model.reset(new stai_mpu_network(model_path, true));
+				m_stai_mpu_model.reset(new stai_mpu_network(model_path, true, options));
 			} else {
-				m_stai_mpu_model.reset(new stai_mpu_network(model_path, false));
+				m_stai_mpu_model.reset(new stai_mpu_network(model_path, false, options));
 			}
+			m_runner.reset(new stai_mpu_runner(*m_stai_mpu_model, startup_stats, m_cpuAffinityMask));
 			m_input_infos = m_stai_mpu_model->get_input_infos();
 			m_output_infos = m_stai_mpu_model->get_output_infos();
 			m_num_inputs = m_stai_mpu_model->get_num_inputs();
@@ -102,8 +111,18 @@ namespace wrapper_stai_mpu{
 			g_print("m_input_channels %d \n", m_input_channels);
 			m_sizeInBytes = m_input_height * m_input_width * m_input_channels;
 			g_print("m_sizeInBytes %d \n", m_sizeInBytes);
-			m_input_tensor_int = new uint8_t[m_sizeInBytes];
-			m_input_tensor_f = new float[m_sizeInBytes];
+			/* Quantized uint8 models take the frame as is, any other input data
+			 * type is converted in a single pass by the preprocessor */
+			if (m_input_infos[0].get_dtype() != stai_mpu_dtype::STAI_MPU_DTYPE_UINT8) {
+				stai_mpu_preprocess_params params;
+				params.width = m_input_width;
+				params.height = m_input_height;
+				params.channels = m_input_channels;
+				params.set_normalization(m_inputMean, m_inputStd);
+				params.half_as_float = GetBackendEngine() == stai_mpu_backend_engine::STAI_MPU_OVX_NPU_ENGINE;
+				m_preprocessor.reset(new stai_mpu_preprocessor(m_input_infos[0], params));
+				m_input_tensor.resize(m_preprocessor->get_output_size_in_bytes());
+			}
 
 		}
 
@@ -111,8 +130,7 @@ namespace wrapper_stai_mpu{
 		int GetInputWidth()
 		{
 			for (int i = 0; i < m_num_inputs; i++) {
-				stai_mpu_tensor input_info = m_input_infos[i];
-				m_input_shape = input_info.get_shape();
+				m_input_shape = m_input_infos[i].get_shape();
 			}
 			int input_width = m_input_shape[1];
 			return input_width;
@@ -122,8 +140,7 @@ namespace wrapper_stai_mpu{
 		int GetInputHeight()
 		{
 			for (int i = 0; i < m_num_inputs; i++) {
-				stai_mpu_tensor input_info = m_input_infos[i];
-				m_input_shape = input_info.get_shape();
+				m_input_shape = m_input_infos[i].get_shape();
 			}
 			int input_height = m_input_shape[2];
 			return input_height;
@@ -133,8 +150,7 @@ namespace wrapper_stai_mpu{
 		int GetInputChannels()
 		{
 			for (int i = 0; i < m_num_inputs; i++) {
-				stai_mpu_tensor input_info = m_input_infos[i];
-				m_input_shape = input_info.get_shape();
+				m_input_shape = m_input_infos[i].get_shape();
 			}
 			int input_channels = m_input_shape[3];
 			if (input_channels==1)
@@ -155,55 +171,90 @@ namespace wrapper_stai_mpu{
 		}
 
 		/* Get the ouput shape of the NN model */
-		std::vector<int> GetOutputShape(int index)
+		const std::vector<int>& GetOutputShape(int index)
 		{
-			for (int i = 0; i < m_num_outputs; i++) {
-				stai_mpu_tensor output_info = m_output_infos[i];
-				m_output_shape = output_info.get_shape();
-			}
-			return m_output_shape;
+			return m_output_infos[index].get_shape();
 		}
 
 		/* Get the input shape of the NN model */
-		std::vector<int> GetInputShape(int index)
+		const std::vector<int>& GetInputShape(int index)
 		{
-			for (int i = 0; i < m_num_inputs; i++) {
-				stai_mpu_tensor input_info = m_input_infos[i];
-				m_input_shape = input_info.get_shape();
-			}
-			return m_input_shape;
+			return m_input_infos[index].get_shape();
+		}
+
+		/* Get the output tensors information, read once at initialization */
+		const std::vector<stai_mpu_tensor>& GetOutputInfos()
+		{
+			return m_output_infos;
 		}
 
 		/* Get the inference time of the NN model */
 		float GetInferenceTime()
 		{
-			return m_inferenceTime;
+			return m_runner->get_last_run_ms();
+		}
+
+		/* Get the backend engine used to run the NN model */
+		stai_mpu_backend_engine GetBackendEngine()
+		{
+			return m_runner->get_backend_engine();
+		}
+
+		/**
+		 * Get a borrowed view on an NN model output. The memory is owned by the
+		 * runner and must not be freed, whatever the backend engine is.
+		 */
+		const void* GetOutputView(int index)
+		{
+			return m_runner->get_output_view(index);
 		}
 
 		/* Run the NN model inference based on the input image */
-		void RunInference(uint8_t* img)
-		{
-			bool floating_model = false;
-
-			if (m_input_infos[0].get_dtype() == stai_mpu_dtype::STAI_MPU_DTYPE_FLOAT32){
-					floating_model = true;
-					g_print("model inputs are float \n");
-				}
-			if (floating_model) {
-				for (int i = 0; i < m_sizeInBytes; i++)
-					m_input_tensor_f[i] = (img[i] - m_inputMean) / m_inputStd;
-				m_stai_mpu_model->set_input(0, m_input_tensor_f);
+		void RunInference(const uint8_t* img, size_t row_stride = 0)
+		{
+			PrepareInput(img, row_stride);
+			Run();
+		}
+
+		/**
+		 * Preprocess the input image and set it as NN model input. The rows
+		 * of the image may be padded (e.g. DCMIPP buffers aligned on 16
+		 * pixels): row_stride is then the number of bytes between two rows,
+		 * and the rows are gathered directly into the input tensor.
+		 */
+		void PrepareInput(const uint8_t* img, size_t row_stride = 0)
+		{
+			size_t row_bytes = m_input_width * m_input_channels;
+			if (m_preprocessor) {
+				m_preprocessor->run(img, m_input_tensor.data(), row_stride);
+				m_runner->bind_input(0, m_input_tensor.data(), m_input_tensor.size());
+			} else if (row_stride == 0 || row_stride == row_bytes) {
+				m_runner->bind_input(0, img, m_sizeInBytes);
 			} else {
-				for (int i = 0; i < m_sizeInBytes; i++)
-					m_input_tensor_int[i] = img[i];
-				m_stai_mpu_model->set_input(0, m_input_tensor_int);
+				if (row_stride < row_bytes)
+					throw std::runtime_error("[WRAPPER] Row stride smaller than an input row");
+				m_input_tensor.resize(m_sizeInBytes);
+				for (int row = 0; row < m_input_height; row++)
+					std::memcpy(m_input_tensor.data() + row * row_bytes, img + row * row_stride, row_bytes);
+				m_runner->bind_input(0, m_input_tensor.data(), m_sizeInBytes);
 			}
+		}
 
-			struct timeval start_time, stop_time;
-			gettimeofday(&start_time, nullptr);
-			m_stai_mpu_model->run();
-			gettimeofday(&stop_time, nullptr);
-			m_inferenceTime = (get_ms(stop_time) - get_ms(start_time));
+		/* Run the NN model inference on the input previously set */
+		bool Run()
+		{
+			return m_runner->run();
+		}
+
+		/**
+		 * Get the latency statistics of the set_input, run and get_output
+		 * phases since the initialization, along with the load and warm-up
+		 * timings. The asynchronous runs, the warm-up and the statistics reset
+		 * are available on m_runner.
+		 */
+		stai_mpu_network_stats GetStats()
+		{
+			return m_runner->get_stats();
 		}
 
 	};
@@ -11,11 +11,17 @@
 #ifndef SSD_MOBILENET_PP_HPP_
 #define SSD_MOBILENET_PP_HPP_
 
+#include <algorithm>
+#include <cmath>
+#include <cstring>
 #include <memory>
+#include <stdexcept>
 #include <string>
 #include <vector>
 #include <fstream>
-#include "stai_mpu_network.h"
+#include "stai_mpu_wrapper.hpp"
+#include "stai_mpu_nms.h"
+#include "stai_mpu_quant.h"
 
 #define LOG(x) std::cerr
 
@@ -44,162 +50,267 @@ namespace nn_postproc{
 	};
 
 	/**
-	 * Return time value in millisecond
+	 * Post processing of the raw SSD MobileNet v2 outputs (class predictions,
+	 * encoded boxes and anchors). The scratch buffers are sized once from the
+	 * output shapes, so that processing a frame does not allocate any memory.
+	 * The anchors are constant for a model: they are read once and kept as
+	 * separate arrays of corners and sizes. For 8 bits quantized outputs, the
+	 * confidence threshold is converted in the quantized domain so that the
+	 * raw scores are filtered without being dequantized, only the scores and
+	 * boxes of the candidates being dequantized. The Non Max Suppression
+	 * only considers the best scored candidates.
 	 */
-	double get_ms(struct timeval t) { return (t.tv_sec * 1000 + t.tv_usec / 1000); }
-
-	/**
-	 * Function used to filter the raw NN output by score
-	 * Each results that are not over the confidence threshold are dropped
-	 * Return the vector of box index that are over the threshold
-	 */
-	std::vector<int> Filter_by_score(float* predictions, int rows, int cols, float confidence_thresh) {
-	std::vector<int> filtered_indexes;
-	for (int i = 0; i < rows; ++i) {
-		bool value_over_threshold = false;
-		for (int j = 1; j < cols; ++j) {  // Start from column 1 as per your requirement
-			if (predictions[i * cols + j] > confidence_thresh) {
-				value_over_threshold = true;
-				break;  // No need to check other values in the same row
-			}
-		}
-		if (value_over_threshold) {
-			filtered_indexes.push_back(i);  // Store the row index
+	class SsdPostProcessor {
+	public:
+		SsdPostProcessor() :
+			m_number_of_boxes(0),
+			m_number_of_classes(0),
+			m_number_of_coordinates(0),
+			m_max_detections(0),
+			m_scores_dtype(stai_mpu_dtype::STAI_MPU_DTYPE_FLOAT32),
+			m_scores_scale(1.0f),
+			m_scores_zero_point(0),
+			m_boxes_dtype(stai_mpu_dtype::STAI_MPU_DTYPE_FLOAT32),
+			m_boxes_scale(1.0f),
+			m_boxes_zero_point(0),
+			m_anchors_ready(false)
+		{}
+
+		/**
+		 * Function used to size the scratch buffers from the output shapes
+		 * of the model, at most max_detections boxes being kept per frame
+		 * out of the nms_top_k best scored candidates (0 for all of them).
+		 * The backend tells whether the half precision outputs are read as
+		 * float32, as the OVX backend converts them.
+		 */
+		void Initialize(const std::vector<stai_mpu_tensor>& output_infos, size_t max_detections, size_t nms_top_k,
+				stai_mpu_backend_engine backend)
+		{
+			bool half_as_float = backend == stai_mpu_backend_engine::STAI_MPU_OVX_NPU_ENGINE;
+			const std::vector<int>& output_shape_0 = output_infos[0].get_shape();
+			const std::vector<int>& output_shape_1 = output_infos[1].get_shape();
+			m_number_of_boxes = output_shape_0[1];
+			m_number_of_classes = output_shape_0[2];
+			m_number_of_coordinates = output_shape_1[2];
+			if (m_number_of_coordinates != 4)
+				throw std::runtime_error("[POSTPROC] Unsupported number of box coordinates");
+			m_max_detections = max_detections;
+			m_scores_dtype = GetOutputType(output_infos[0], half_as_float, &m_scores_scale, &m_scores_zero_point);
+			m_boxes_dtype = GetOutputType(output_infos[1], half_as_float, &m_boxes_scale, &m_boxes_zero_point);
+			m_anchors_x0.resize(m_number_of_boxes);
+			m_anchors_y0.resize(m_number_of_boxes);
+			m_anchors_x1.resize(m_number_of_boxes);
+			m_anchors_y1.resize(m_number_of_boxes);
+			m_anchors_w.resize(m_number_of_boxes);
+			m_anchors_h.resize(m_number_of_boxes);
+			m_anchors_ready = false;
+			m_candidates.resize(m_number_of_boxes);
+			m_keep.resize(m_number_of_boxes);
+			m_nms.reserve(m_number_of_boxes);
+			/* The boxes suppress each other whatever their class */
+			m_nms_params.class_aware = false;
+			m_nms_params.top_k = nms_top_k;
 		}
-	}
-	return filtered_indexes;
-	}
 
-	/**
-	 * Function used to decode raw NN output using associated anchors
-	 * Return a float vector of decoded outputs
-	 */
-	std::vector<float> BB_decoding(std::vector<float> encoded_bbox, std::vector<float> anchors){
-		std::vector<float> decoded_boxes(encoded_bbox.size());
-		int it = int(encoded_bbox.size())/4;
-		for (int i=0; i<it; i++){
-			float a_xmin = anchors[i * 4];
-			float a_ymin = anchors[i * 4 + 1];
-			float a_xmax = anchors[i * 4 + 2];
-			float a_ymax = anchors[i * 4 + 3];
-
-			float bb_xmin = encoded_bbox[i * 4];
-			float bb_ymin = encoded_bbox[i * 4 + 1];
-			float bb_xmax = encoded_bbox[i * 4 + 2];
-			float bb_ymax = encoded_bbox[i * 4 + 3];
-
-			float w = a_xmax - a_xmin;
-			float h = a_ymax - a_ymin;
-
-			float decoded_xmin = bb_xmin * w;
-			float decoded_ymin = bb_ymin * h;
-			float decoded_xmax = bb_xmax * w;
-			float decoded_ymax = bb_ymax * h;
-
-			decoded_xmin += a_xmin;
-			decoded_ymin += a_ymin;
-			decoded_xmax += a_xmax;
-			decoded_ymax += a_ymax;
-			decoded_boxes[i * 4] = decoded_xmin;
-       		decoded_boxes[i * 4 + 1] = decoded_ymin;
-        	decoded_boxes[i * 4 + 2] = decoded_xmax;
-        	decoded_boxes[i * 4 + 3] = decoded_ymax;
+		size_t GetMaxDetections() const
+		{
+			return m_max_detections;
 		}
-		return decoded_boxes;
-	}
-
-	/**
-	 * Function used to calculate intersection over union of two boxes
-	 * Used in the Non Max Suppression process
-	 * Return IOU of the two boxes
-	 */
-	float IoU(const ObjDetect_Location& a, const ObjDetect_Location& b) {
-		float areaA = (a.x1 - a.x0) * (a.y1 - a.y0);
-		if (areaA <= 0.0f) return 0.0f;
 
-		float areaB = (b.x1 - b.x0) * (b.y1 - b.y0);
-		if (areaB <= 0.0f) return 0.0f;
+		bool HasAnchors() const
+		{
+			return m_anchors_ready;
+		}
 
-		float intersectionMinX = std::max(a.x0, b.x0);
-		float intersectionMaxX = std::min(a.x1, b.x1);
-		float intersectionMinY = std::max(a.y0, b.y0);
-		float intersectionMaxY = std::min(a.y1, b.y1);
+		/**
+		 * Function used to store the anchors output of the model, given as
+		 * xmin, ymin, xmax, ymax per box, along with their width and height
+		 */
+		void SetAnchors(const stai_mpu_tensor& anchors_info, const void* anchors_data, stai_mpu_backend_engine backend)
+		{
+			std::vector<float> anchors(anchors_info.get_num_elements());
+			/* The OVX backend already converts the half precision outputs to float32 */
+			stai_mpu_dequantize(anchors_info, anchors_data, anchors.data(),
+					    backend == stai_mpu_backend_engine::STAI_MPU_OVX_NPU_ENGINE);
+			for (int box = 0; box < m_number_of_boxes; ++box) {
+				const float* anchor = anchors.data() + box * 4;
+				m_anchors_x0[box] = anchor[0];
+				m_anchors_y0[box] = anchor[1];
+				m_anchors_x1[box] = anchor[2];
+				m_anchors_y1[box] = anchor[3];
+				m_anchors_w[box] = anchor[2] - anchor[0];
+				m_anchors_h[box] = anchor[3] - anchor[1];
+			}
+			m_anchors_ready = true;
+		}
 
-		float intersectionArea = std::max(0.0f, intersectionMaxX - intersectionMinX) *
-								std::max(0.0f, intersectionMaxY - intersectionMinY);
+		/**
+		 * Function used to filter, decode and apply the Non Max Suppression
+		 * to the raw outputs, the anchors having been set. The kept boxes are
+		 * written by descending score in detections, which can hold capacity
+		 * boxes.
+		 * Return the number of boxes written
+		 */
+		size_t Process(const void* class_prediction, const void* box_encoded,
+			       float confidence_thresh, float iou_threshold,
+			       ObjDetect_Results* detections, size_t capacity)
+		{
+			m_nms.clear();
+			switch (m_scores_dtype) {
+				case stai_mpu_dtype::STAI_MPU_DTYPE_UINT8:
+					FilterQuantizedScores(static_cast<const uint8_t*>(class_prediction), box_encoded, confidence_thresh);
+					break;
+				case stai_mpu_dtype::STAI_MPU_DTYPE_INT8:
+					FilterQuantizedScores(static_cast<const int8_t*>(class_prediction), box_encoded, confidence_thresh);
+					break;
+				default:
+					FilterScores(static_cast<const float*>(class_prediction), box_encoded, confidence_thresh);
+					break;
+			}
 
-		return intersectionArea / (areaA + areaB - intersectionArea);
-	}
+			/* Non Max Suppression: the boxes are taken by descending score,
+			 * the ones overlapping too much a kept box being dropped */
+			m_nms_params.iou_threshold = iou_threshold;
+			m_nms_params.max_output = std::min(capacity, m_keep.size());
+			size_t number_of_detections = m_nms.run(m_nms_params, m_keep.data());
+			for (size_t i = 0; i < number_of_detections; ++i)
+				detections[i] = m_candidates[m_keep[i]];
+			return number_of_detections;
+		}
 
-	/**
-	 * Function used to reproduce Non Max Supression technique
-	 * This technique is used to filter boxes that are redondant
-	 * or with too much overlap
-	 * Return the final vector of ObjDetect_Results
-	 */
-	std::vector<ObjDetect_Results> non_max_suppression(const std::vector<float>& bb_predictions, std::vector<int>& class_index, std::vector<float>& filtered_scores,float iou_threshold) {
-		const size_t box_size = 4;
-		size_t num_boxes = bb_predictions.size() / box_size;
-		std::vector<ObjDetect_Results> boxes(num_boxes);
-		std::vector<int>::iterator result;
-		// Convert the flat vector to BoxInfo structs
-		for (size_t i = 0; i < num_boxes; ++i) {
-			boxes[i].location.x0 = bb_predictions[i * box_size];
-			boxes[i].location.y0 = bb_predictions[i * box_size + 1];
-			boxes[i].location.x1 = bb_predictions[i * box_size + 2];
-			boxes[i].location.y1 = bb_predictions[i * box_size + 3];
-			boxes[i].score = filtered_scores[i];
-			boxes[i].class_index = class_index[i];
+	private:
+		/**
+		 * Function used to get the data type the output is read as, along
+		 * with its affine quantization parameters when it is quantized on 8
+		 * bits. The half precision outputs are read as float32 when the
+		 * backend converts them.
+		 */
+		static stai_mpu_dtype GetOutputType(const stai_mpu_tensor& info, bool half_as_float, float* scale, int32_t* zero_point)
+		{
+			stai_mpu_dtype dtype = info.get_dtype();
+			const stai_mpu_quant_params& qparams = info.get_qparams();
+			if (dtype == stai_mpu_dtype::STAI_MPU_DTYPE_FLOAT32)
+				return dtype;
+			if (half_as_float && (dtype == stai_mpu_dtype::STAI_MPU_DTYPE_FLOAT16 ||
+					      dtype == stai_mpu_dtype::STAI_MPU_DTYPE_BFLOAT16))
+				return stai_mpu_dtype::STAI_MPU_DTYPE_FLOAT32;
+			if (dtype == stai_mpu_dtype::STAI_MPU_DTYPE_UINT8 || dtype == stai_mpu_dtype::STAI_MPU_DTYPE_INT8) {
+				if (info.get_qtype() == stai_mpu_qtype::STAI_MPU_QTYPE_STATIC_AFFINE) {
+					*scale = qparams.static_affine.scale;
+					*zero_point = (int32_t)qparams.static_affine.zero_point;
+					return dtype;
+				}
+				if (info.get_qtype() == stai_mpu_qtype::STAI_MPU_QTYPE_DYNAMIC_FIXED_POINT &&
+				    dtype == stai_mpu_dtype::STAI_MPU_DTYPE_INT8) {
+					*scale = std::ldexp(1.0f, -qparams.dfp.fixed_point_pos);
+					*zero_point = 0;
+					return dtype;
+				}
+			}
+			throw std::runtime_error("[POSTPROC] Unsupported data type for the output " + info.get_name());
 		}
 
-		// Sort boxes by score in descending order
-		std::vector<int> indices(num_boxes);
-		std::iota(indices.begin(), indices.end(), 0);
-		std::sort(indices.begin(), indices.end(), [&boxes](int a, int b) {
-			return boxes[a].score > boxes[b].score;
-		});
-
-		std::vector<bool> suppressed(num_boxes, false);
-		std::vector<ObjDetect_Results> final_output;
-		ObjDetect_Results bb_keeped;
-
-		// Filter boxes to keep and to remove based on IOU
-		for (size_t i = 0; i < num_boxes; ++i) {
-			if (suppressed[indices[i]]) {
-				continue;
+		/**
+		 * Function used to decode a box against its anchor and append it to
+		 * the candidates of the Non Max Suppression
+		 */
+		void AddCandidate(int box, const void* box_encoded, float score, int class_index)
+		{
+			float bb[4];
+			switch (m_boxes_dtype) {
+				case stai_mpu_dtype::STAI_MPU_DTYPE_UINT8:
+					stai_mpu_dequantize(static_cast<const uint8_t*>(box_encoded) + box * 4, bb, 4, m_boxes_scale, m_boxes_zero_point);
+					break;
+				case stai_mpu_dtype::STAI_MPU_DTYPE_INT8:
+					stai_mpu_dequantize(static_cast<const int8_t*>(box_encoded) + box * 4, bb, 4, m_boxes_scale, m_boxes_zero_point);
+					break;
+				default:
+					std::memcpy(bb, static_cast<const float*>(box_encoded) + box * 4, sizeof(bb));
+					break;
 			}
+			float w = m_anchors_w[box];
+			float h = m_anchors_h[box];
+			ObjDetect_Results& candidate = m_candidates[m_nms.size()];
+			candidate.location.x0 = bb[0] * w + m_anchors_x0[box];
+			candidate.location.y0 = bb[1] * h + m_anchors_y0[box];
+			candidate.location.x1 = bb[2] * w + m_anchors_x1[box];
+			candidate.location.y1 = bb[3] * h + m_anchors_y1[box];
+			candidate.score = score;
+			candidate.class_index = class_index;
+			m_nms.add(candidate.location.x0, candidate.location.y0,
+				  candidate.location.x1, candidate.location.y1,
+				  score, class_index);
+		}
 
-			int idx = indices[i];
-			bb_keeped.location.x0 = boxes[idx].location.x0;
-			bb_keeped.location.y0 = boxes[idx].location.y0;
-			bb_keeped.location.x1 = boxes[idx].location.x1;
-			bb_keeped.location.y1 = boxes[idx].location.y1;
-			bb_keeped.score = boxes[idx].score;
-			bb_keeped.class_index = boxes[idx].class_index;
-			final_output.push_back(bb_keeped);
-			for (size_t j = i + 1; j < num_boxes; ++j) {
-				if (!suppressed[indices[j]] && IoU(boxes[idx].location, boxes[indices[j]].location) > iou_threshold) {
-					suppressed[indices[j]] = true;
+		/**
+		 * Function used to keep the boxes whose best class (the background
+		 * class 0 being skipped) is over the threshold, in a single pass
+		 */
+		void FilterScores(const float* class_prediction, const void* box_encoded, float confidence_thresh)
+		{
+			for (int box = 0; box < m_number_of_boxes; ++box) {
+				const float* scores = class_prediction + box * m_number_of_classes;
+				int class_index = 1;
+				float score = scores[1];
+				for (int j = 2; j < m_number_of_classes; ++j) {
+					if (scores[j] > score) {
+						score = scores[j];
+						class_index = j;
+					}
 				}
+				if (score <= confidence_thresh)
+					continue;
+				AddCandidate(box, box_encoded, score, class_index);
 			}
 		}
-		return final_output;
-	}
 
-	/**
-	 * Function used to extract from the class prediction output relevant information such as
-	 * highest score and class index
-	 */
-	void recover_score_info(const std::vector<float>& scores, int number_of_boxes, int number_of_classes,
-                                 std::vector<float>& highest_scores, std::vector<int>& class_indices){
-		for (int box = 0; box < number_of_boxes; ++box) {
-			int start_index = box * number_of_classes;
-			auto max_it = std::max_element(scores.begin() + start_index + 1, scores.begin() + start_index + number_of_classes);
-			highest_scores.push_back(*max_it);
-			class_indices.push_back(std::distance(scores.begin() + start_index, max_it));
+		/**
+		 * Same as FilterScores() on raw quantized scores, compared against the
+		 * threshold converted once in the quantized domain. The dequantization
+		 * being monotonic, the best class is found on the raw scores and only
+		 * its score is dequantized.
+		 */
+		template<typename T>
+		void FilterQuantizedScores(const T* class_prediction, const void* box_encoded, float confidence_thresh)
+		{
+			int32_t bound = stai_mpu_quantize_threshold<T>(confidence_thresh, m_scores_scale, m_scores_zero_point);
+			for (int box = 0; box < m_number_of_boxes; ++box) {
+				const T* scores = class_prediction + box * m_number_of_classes;
+				if (!stai_mpu_any_above(scores + 1, m_number_of_classes - 1, bound))
+					continue;
+				int class_index = 1;
+				for (int j = 2; j < m_number_of_classes; ++j) {
+					if (scores[j] > scores[class_index])
+						class_index = j;
+				}
+				float score;
+				stai_mpu_dequantize(scores + class_index, &score, 1, m_scores_scale, m_scores_zero_point);
+				AddCandidate(box, box_encoded, score, class_index);
+			}
 		}
-	}
 
+		int m_number_of_boxes;
+		int m_number_of_classes;
+		int m_number_of_coordinates;
+		size_t m_max_detections;
+		stai_mpu_dtype m_scores_dtype;
+		float m_scores_scale;
+		int32_t m_scores_zero_point;
+		stai_mpu_dtype m_boxes_dtype;
+		float m_boxes_scale;
+		int32_t m_boxes_zero_point;
+		bool m_anchors_ready;
+		std::vector<float> m_anchors_x0;
+		std::vector<float> m_anchors_y0;
+		std::vector<float> m_anchors_x1;
+		std::vector<float> m_anchors_y1;
+		std::vector<float> m_anchors_w;
+		std::vector<float> m_anchors_h;
+		std::vector<ObjDetect_Results> m_candidates;
+		std::vector<uint32_t> m_keep;
+		stai_mpu_nms m_nms;
+		stai_mpu_nms_params m_nms_params;
+	};
 
 	/**
 	 * NN post processing :
@@ -208,77 +319,38 @@ namespace nn_postproc{
 	 * Filter
 	 * Populate Frame result structure for drawing phase
 	 */
-	void nn_post_proc(std::unique_ptr<stai_mpu_network>& nn_model,std::vector<stai_mpu_tensor> output_infos, Frame_Results* results, float confidenceThresh, float iou_threshold, std::string model_type)
+	void nn_post_proc(wrapper_stai_mpu::stai_mpu_wrapper& nn_model,const std::vector<stai_mpu_tensor>& output_infos, Frame_Results* results, float confidenceThresh, float iou_threshold, const std::string& model_type, SsdPostProcessor* ssd_pp)
 	{
-		std::string ssd_mobilenet_v1_type = "ssd_mobilenet_v1";
-		std::string ssd_mobilenet_v2_type = "ssd_mobilenet_v2";
-
-		if (model_type == ssd_mobilenet_v2_type){
-
-			/* Get output size */
-			std::vector<int> output_shape_0 = output_infos[0].get_shape();
-			std::vector<int> output_shape_1 = output_infos[1].get_shape();
-			int number_of_boxes = output_shape_0[1];
-			int number_of_classes = output_shape_0[2];
-			int number_of_coordinates = output_shape_1[2];
+		if (model_type == "ssd_mobilenet_v2"){
 
 			/* Get backend used */
-			results->ai_backend = nn_model->get_backend_engine();
+			results->ai_backend = nn_model.GetBackendEngine();
 
 			/* Get inference outputs */
-			float* box_encoded = static_cast<float*>(nn_model->get_output(1));
-			float* class_prediction = static_cast<float*>(nn_model->get_output(0));
-			float* anchors = static_cast<float*>(nn_model->get_output(2));
-
-			/* First filtering by score */
-			std::vector<int> filtered_indexes = Filter_by_score(class_prediction, number_of_boxes, number_of_classes, confidenceThresh);
-			std::vector<float>  filtered_encoded_bb(filtered_indexes.size()*number_of_coordinates);
-			std::vector<float>  filtered_anchors(filtered_indexes.size()*number_of_coordinates);
-			std::vector<float>  filtered_class_prediction(filtered_indexes.size()*number_of_classes);
-
-			// Copy the filtered elements into the new vectors of bb and anchors
-			for (size_t i = 0; i < filtered_indexes.size(); ++i) {
-				int row_index = filtered_indexes[i];
-				for (int j = 0; j < number_of_coordinates; ++j) {
-					filtered_encoded_bb[i * number_of_coordinates + j] = box_encoded[row_index * number_of_coordinates + j];
-					filtered_anchors[i * number_of_coordinates + j] = anchors[row_index * number_of_coordinates + j];
-				}
-			}
-
-			// Copy the filtered elements into the new vectors of bb and anchors
-			for (size_t i = 0; i < filtered_indexes.size(); ++i) {
-				int row_index = filtered_indexes[i];
-				for (int j = 0; j < number_of_classes; ++j) {
-					filtered_class_prediction[i * number_of_classes + j] = class_prediction[row_index * number_of_classes + j];
-				}
-			}
-
-			/* Decode raw output of the NN model */
-			std::vector<float> decoded_bb = BB_decoding(filtered_encoded_bb, filtered_anchors);
+			const void* box_encoded = nn_model.GetOutputView(1);
+			const void* class_prediction = nn_model.GetOutputView(0);
 
-			/* Reformat output */
-			std::vector<float> score;
-			std::vector<int> class_index;
-			recover_score_info(filtered_class_prediction,filtered_indexes.size(),number_of_classes,score,class_index);
+			/* The anchors are constant, they are only read after the first inference */
+			if (!ssd_pp->HasAnchors())
+				ssd_pp->SetAnchors(output_infos[2], nn_model.GetOutputView(2), results->ai_backend);
 
-			/* Apply NMS based filtering */
-			results->vect_ObjDetect_Results = non_max_suppression(decoded_bb,class_index,score,iou_threshold);
-
-			/* Release memory */
-			if (results->ai_backend == stai_mpu_backend_engine::STAI_MPU_OVX_NPU_ENGINE){
-				free(box_encoded);
-				free(class_prediction);
-				free(anchors);
-			}
+			/* Filter, decode and apply NMS, the results vector only being
+			 * resized within its capacity after the first frame */
+			std::vector<ObjDetect_Results>& detections = results->vect_ObjDetect_Results;
+			detections.resize(ssd_pp->GetMaxDetections());
+			size_t number_of_detections = ssd_pp->Process(class_prediction, box_encoded,
+								      confidenceThresh, iou_threshold,
+								      detections.data(), detections.size());
+			detections.resize(number_of_detections);
 
-		} else if (model_type == ssd_mobilenet_v1_type){
+		} else if (model_type == "ssd_mobilenet_v1"){
 
-			float *locations = static_cast<float*>(nn_model->get_output(0));
-			float *classes = static_cast<float*>(nn_model->get_output(1));
-			float *scores = static_cast<float*>(nn_model->get_output(2));
+			const float *locations = static_cast<const float*>(nn_model.GetOutputView(0));
+			const float *classes = static_cast<const float*>(nn_model.GetOutputView(1));
+			const float *scores = static_cast<const float*>(nn_model.GetOutputView(2));
 
 			/* Get output size */
-			std::vector<int> output_shape = output_infos[1].get_shape();
+			const std::vector<int>& output_shape = output_infos[1].get_shape();
 			unsigned int output_size  = output_shape[output_shape.size()-1];
 
 			// creation of an ObjDetect_Results struct to store values
@@ -7,7 +7,7 @@
 # in the root directory of this software component.
 # If no LICENSE file comes with this software, it is provided AS-IS.
 
-from stai_mpu import stai_mpu_network
+from stai_mpu import stai_mpu_network, preprocess, nms
 import numpy as np
 from timeit import default_timer as timer
 import math
@@ -49,6 +49,8 @@ class NeuralNetwork:
         self._input_std = input_std
         self.confidence_threshold = confidence_thresh
         self.iou_threshold  = iou_threshold
+        # Number of best scored boxes entering the Non Max Suppression
+        self.nms_top_k = 300
         self.number_of_boxes = 0
 
         # Initialize NN model
@@ -61,11 +63,17 @@ class NeuralNetwork:
         # Read input tensor information
         self.num_inputs = self.stai_mpu_model.get_num_inputs()
         self.input_tensor_infos = self.stai_mpu_model.get_input_infos()
+        self._preprocess = preprocess.Preprocessor(self._input_mean, self._input_std)
 
         # Read output tensor information
         self.num_outputs = self.stai_mpu_model.get_num_outputs()
         self.output_tensor_infos = self.stai_mpu_model.get_output_infos()
 
+        # The anchors output of ssd_mobilenet_v2 is constant, it is read once
+        # after the first inference along with the anchor sizes
+        self._anchors = None
+        self._anchor_sizes = None
+
         # Load labels
         self._labels = load_labels(self._label_file)
 
@@ -96,7 +104,7 @@ class NeuralNetwork:
 
         # preprocess input data if necessary
         if self.input_tensor_infos[0].get_dtype() == np.float32:
-            input_data = (np.float32(input_data) - self._input_mean) / self._input_std
+            input_data = self._preprocess(input_data)
 
         # set NN model input with input data
         self.stai_mpu_model.set_input(0, input_data)
@@ -116,10 +124,13 @@ class NeuralNetwork:
         self.stai_backend = self.stai_mpu_model.get_backend_engine()
 
         if self.model_type == "ssd_mobilenet_v2":
-            anchors = self.stai_mpu_model.get_output(index=2)
+            if self._anchors is None:
+                self._anchors = np.array(self.stai_mpu_model.get_output(index=2)[0], dtype=np.float32)
+                sizes = self._anchors[:, 2:4] - self._anchors[:, 0:2]
+                self._anchor_sizes = np.concatenate((sizes, sizes), axis=1)
             encoded_boxes = self.stai_mpu_model.get_output(index=1)
             class_prediction = self.stai_mpu_model.get_output(index=0)
-            locations, classes, scores = self.postprocess_predictions(class_prediction,encoded_boxes,anchors, nms_thresh=self.iou_threshold, confidence_thresh=self.confidence_threshold)
+            locations, classes, scores = self.postprocess_predictions(class_prediction,encoded_boxes, nms_thresh=self.iou_threshold, confidence_thresh=self.confidence_threshold)
         elif self.model_type == "ssd_mobilenet_v1" and ("ORT_CPU" in  self.stai_backend.name):
             locations = self.stai_mpu_model.get_output(index=0).copy()
             classes = self.stai_mpu_model.get_output(index=1).copy()
@@ -138,67 +149,23 @@ class NeuralNetwork:
         if len(decoded_boxes) == 0:
             return np.array([]),np.array([]),np.array([])
 
-        bb_keeped_idexes = []
-        x1 = decoded_boxes[:,0]
-        y1 = decoded_boxes[:,1]
-        x2 = decoded_boxes[:,2]
-        y2 = decoded_boxes[:,3]
-        bb_area = (x2 - x1) * (y2 - y1)
-        sorted_scores = np.argsort(scores)[::-1]
-        while len(sorted_scores) > 0:
-            i = sorted_scores[0]
-            bb_keeped_idexes.append(i)
-
-            xmax = np.maximum(x1[i], x1[sorted_scores[1:]])
-            ymax = np.maximum(y1[i], y1[sorted_scores[1:]])
-            xmin = np.minimum(x2[i], x2[sorted_scores[1:]])
-            ymin = np.minimum(y2[i], y2[sorted_scores[1:]])
-
-            w, h = np.maximum(0, xmin - xmax), np.maximum(0, ymin - ymax)
-            overlap_area = w * h
-            overlap = overlap_area / (bb_area[i] + bb_area[sorted_scores[1:]] - overlap_area)
-            inds = np.where(overlap <= iou_threshold)[0]
-            sorted_scores = sorted_scores[inds + 1]
-        if bb_keeped_idexes :
+        bb_keeped_idexes = nms.non_max_suppression(decoded_boxes, scores, iou_threshold, top_k=self.nms_top_k)
+        if len(bb_keeped_idexes) > 0:
             return decoded_boxes[bb_keeped_idexes], scores[bb_keeped_idexes], classes[bb_keeped_idexes]
         else:
             return np.array([]),np.array([]),np.array([])
 
-    def decode_predictions(self, encoded_bbox, anchors):
+    def decode_predictions(self, encoded_bbox, anchor_indexes):
         """
-        Function used to decode raw NN output using associated anchors.
-        Returns a list of decoded outputs.
+        Function used to decode raw NN output using the cached anchors of the
+        given indexes, as xmin, ymin, xmax, ymax scaled by the anchor size.
+        Returns an array of decoded outputs.
         """
-        decoded_boxes = []
-        num_boxes = len(encoded_bbox)
-
-        for i in range(num_boxes):
-            a_xmin =  anchors[i][0]
-            a_ymin =  anchors[i][1]
-            a_xmax =  anchors[i][2]
-            a_ymax =  anchors[i][3]
-
-            bb_xmin = encoded_bbox[i][0]
-            bb_ymin = encoded_bbox[i][1]
-            bb_xmax = encoded_bbox[i][2]
-            bb_ymax = encoded_bbox[i][3]
-
-            w = a_xmax - a_xmin
-            h = a_ymax - a_ymin
-
-            decoded_xmin = bb_xmin * w + a_xmin
-            decoded_ymin = bb_ymin * h + a_ymin
-            decoded_xmax = bb_xmax * w + a_xmax
-            decoded_ymax = bb_ymax * h + a_ymax
-
-            decoded_boxes.append((decoded_xmin,decoded_ymin,decoded_xmax,decoded_ymax))
-        decoded_boxes = np.array(decoded_boxes)
-        return decoded_boxes
+        return encoded_bbox * self._anchor_sizes[anchor_indexes] + self._anchors[anchor_indexes]
 
     def postprocess_predictions(self,
                                 predicted_scores,
                                 predicted_boxes,
-                                predicted_anchors,
                                 nms_thresh: float = 0.45,
                                 confidence_thresh: float = 0.70):
         """
@@ -208,12 +175,10 @@ class NeuralNetwork:
         #Filter bounding boxes by the confidence threshold
         predicted_scores = predicted_scores[0]
         predicted_boxes = predicted_boxes[0]
-        predicted_anchors = predicted_anchors[0]
 
         filtered_classes_indexes = np.where(np.any(predicted_scores[:,1:81] > confidence_thresh, axis=1))[0]
 
         filtered_prediction = predicted_boxes[filtered_classes_indexes]
-        filtered_anchors = predicted_anchors[filtered_classes_indexes]
 
         #Extract Score and Classes
         class_prediction = predicted_scores[filtered_classes_indexes]
@@ -221,7 +186,7 @@ class NeuralNetwork:
         filtered_class = np.argmax(class_prediction, axis=1)
 
         #Decode raw predictions outputs
-        decoded_bb = self.decode_predictions(filtered_prediction,filtered_anchors)
+        decoded_bb = self.decode_predictions(filtered_prediction,filtered_classes_indexes)
 
         #Remove overlapping bounding boxes
         locations, scores, classes = self.non_max_supression(decoded_bb,np.array(filtered_score),np.array(filtered_class),nms_thresh)
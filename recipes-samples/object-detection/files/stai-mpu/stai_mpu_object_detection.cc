@@ -17,7 +17,7 @@
  *
  * Gstreamer pipeline is used to stream camera frames (using v4l2src), to
  * display a preview (using gtkwaylandsink) and to execute neural network inference
- * (using appsink).
+ * (using appsink, the inference running on a dedicated thread).
  *
  * The result of the inference is displayed on the preview. The overlay is done
  * using GTK widget with cairo.
@@ -26,8 +26,11 @@
  *
   */
 
+#include <atomic>
 #include <filesystem>
 #include <getopt.h>
+#include <semaphore.h>
+#include <sys/time.h>
 #include <glib.h>
 #include <gtk/gtk.h>
 #include <numeric>
@@ -51,6 +54,10 @@
 #include "ssd_mobilenet_pp.hpp"
 
 #define MAX_PRINTED_BOXES 5
+/* Maximum number of boxes kept per frame by the SSD MobileNet v2 post processing */
+#define MAX_DETECTIONS 100
+/* Number of best scored boxes entering its Non Max Suppression */
+#define NMS_TOP_K 300
 
 /* Application parameters */
 std::vector<std::string> dir_files;
@@ -80,6 +87,7 @@ gdouble display_avg_fps = 0;
 struct wrapper_stai_mpu::stai_mpu_wrapper stai_mpu_wrapper;
 struct wrapper_stai_mpu::Config config;
 nn_postproc::Frame_Results results;
+nn_postproc::SsdPostProcessor ssd_post_processor;
 std::vector<std::string> labels;
 
 #define RESOURCES_DIRECTORY  "/usr/local/x-linux-ai/resources/"
@@ -207,6 +215,14 @@ typedef struct _CustomData {
 	/* Color vector for bb */
 	std::vector<BoxColor> boxColors;
 
+	/* NN inference thread, fed by the appsink callback through a single
+	 * slot mailbox holding the latest camera sample */
+	std::thread nn_thread;
+	std::atomic<GstSample*> nn_latest_sample{nullptr};
+	sem_t nn_sample_sem;
+	std::atomic<bool> nn_thread_exit{false};
+	std::atomic<unsigned long> nn_dropped_samples{0};
+
 } CustomData;
 
 /**
@@ -456,9 +472,9 @@ gint valid_timeout_callback(gpointer data)
 /**
  * This function execute an NN inference
  */
-static void nn_inference(uint8_t *img)
+static void nn_inference(uint8_t *img, size_t row_stride = 0)
 {
-	stai_mpu_wrapper.RunInference(img);
+	stai_mpu_wrapper.RunInference(img, row_stride);
 	results.inference_time = stai_mpu_wrapper.GetInferenceTime();
 }
 
@@ -467,7 +483,7 @@ static void nn_inference(uint8_t *img)
  * and extract relevant results => bb coordinates, classes, scores
  */
 static void nn_postprocessing(){
-	nn_postproc::nn_post_proc(stai_mpu_wrapper.m_stai_mpu_model, stai_mpu_wrapper.m_output_infos, &results, confidence_thresh, iou_thresh, results.model_type);
+	nn_postproc::nn_post_proc(stai_mpu_wrapper, stai_mpu_wrapper.m_output_infos, &results, confidence_thresh, iou_thresh, results.model_type, &ssd_post_processor);
 }
 
 /**
@@ -1330,97 +1346,111 @@ static void gui_create_main(CustomData *data)
 }
 
 /**
- * This function is called to preprocess each camera buffer before NN inference
+ * This function is called to get the row stride of each camera buffer before NN inference
  */
-std::vector<uint8_t> gst_preprocess_buffer(GstMapInfo& info, int width, int height, int nnInputWidth) {
+size_t gst_buffer_row_stride(int width, int nnInputWidth) {
 	/*DCMIPP pixelpacker has a constraint on the output resolution that should be multiple of 16.
     the allocated buffer may contains stride to handle the DCMIPP Hw constraints/
     The following code allow to handle both cases by anticipating the size of the
     allocated buffer according to the NN resolution
 	*/
 	int channels = 3;
-	int stride, offset;
 
 	//Calculate the nearest upper multiple of 16
 	if (nnInputWidth % 16 != 0) {
 		int upperMultiple = ((nnInputWidth / 16) + 1) * 16;
-		//Calculate the stride and offset
-		stride = upperMultiple * channels;
-		offset = stride - (width * channels);
+		return upperMultiple * channels;
+	}
+	return width * channels;
+}
+
+/**
+ * This function runs the NN inference and post processing on a camera sample
+ */
+bool first_frame = true;
+static void nn_process_sample(GstSample *sample, CustomData *data)
+{
+	GstBuffer *buffer;
+	GstMapInfo info;
+
+	/* Recover information of the GST sample */
+	GstCaps* caps = gst_sample_get_caps(sample);
+	GstStructure* structure = gst_caps_get_structure(caps, 0);
+	int width, height;
+	gst_structure_get_int(structure, "width", &width);
+	gst_structure_get_int(structure, "height", &height);
+	buffer = gst_sample_get_buffer (sample);
+
+	gst_buffer_map(buffer, &info, GST_MAP_READ);
+
+	#ifdef DEBUG
+		FILE *file = fopen("NN_sample_dump.raw", "wb");
+		if (file != NULL) {
+			fwrite(info.data, info.size, 1, file);
+			fclose(file);
+		}
+	#endif
+
+	if(camera_src_str == "LIBCAMERA"){
+		/* Execute the inference, the rows of the camera buffer being
+		 * gathered into the NN input according to their stride */
+		nn_inference(info.data, gst_buffer_row_stride(width, data->nn_input_width));
 	} else {
-		//Calculate the stride and offset
-		stride = width * channels;
-		offset = 0;
+		/* Execute the inference */
+		nn_inference(info.data);
 	}
+	nn_postprocessing();
+	gst_buffer_unmap(buffer, &info);
+}
+
+/**
+ * This function is the loop of the NN inference thread: each time a sample
+ * is put in the empty mailbox, it takes the latest sample, runs the NN on it
+ * and asks the UI to draw the results
+ */
+static void nn_thread_loop(CustomData *data)
+{
+	while (true) {
+		sem_wait(&data->nn_sample_sem);
+		if (data->nn_thread_exit.load())
+			break;
 
-	int numLines = info.size / stride;
-	std::vector<uint8_t> preprocessedData;
-	//fill the processed buffer properly depending on stride and offset
-	for (int i = 0; i < numLines; ++i) {
-		int startIndex = i * stride;
-		int endIndex = startIndex + (stride - offset);
-		preprocessedData.insert(preprocessedData.end(), info.data + startIndex, info.data + endIndex);
+		GstSample *sample = data->nn_latest_sample.exchange(nullptr);
+		if (!sample)
+			continue;
+		nn_process_sample(sample, data);
+
+		/* We don't need the appsink sample anymore */
+		gst_sample_unref(sample);
+
+		/* Call application callback only in playing state */
+		gst_element_post_message(data->pipeline,
+					 gst_message_new_application(GST_OBJECT(data->pipeline),
+					 gst_structure_new_empty("inference-done")));
 	}
-	return preprocessedData;
 }
 
 /**
- * This function is called when appsink Gstreamer element receives a buffer
+ * This function is called when appsink Gstreamer element receives a buffer.
+ * The sample is handed over to the NN inference thread so that the streaming
+ * thread is never blocked by the inference: a sample the NN thread has not
+ * taken yet is replaced by the new one and dropped.
  */
-bool first_frame = true;
 static GstFlowReturn gst_new_sample_cb(GstElement *sink, CustomData *data)
 {
 	GstSample *sample;
-	GstBuffer *app_buffer, *buffer;
-	GstMapInfo info;
 
-	/* Retrieve the buffer */
+	/* Retrieve the sample, holding a reference on its buffer */
 	g_signal_emit_by_name (sink, "pull-sample", &sample);
 	if (sample) {
-		/* Recover information of the GST sample */
-		GstCaps* caps = gst_sample_get_caps(sample);
-		GstStructure* structure = gst_caps_get_structure(caps, 0);
-		int width, height;
-		gst_structure_get_int(structure, "width", &width);
-		gst_structure_get_int(structure, "height", &height);
-		buffer = gst_sample_get_buffer (sample);
-
-		/* Make a copy */
-		app_buffer = gst_buffer_ref (buffer);
-
-		gst_buffer_map(app_buffer, &info, GST_MAP_READ);
-
-		#ifdef DEBUG
-			FILE *file = fopen("NN_sample_dump.raw", "wb");
-			if (file != NULL) {
-				fwrite(info.data, info.size, 1, file);
-				fclose(file);
-				int ret = GST_FLOW_OK;
-			}
-		#endif
-
-		if(camera_src_str == "LIBCAMERA"){
-			/* Preprocess the camera buffer */
-			std::vector<uint8_t> nn_input_sample;
-			nn_input_sample = gst_preprocess_buffer(info,width,height,data->nn_input_width);
-			/* Execute the inference */
-			nn_inference(nn_input_sample.data());
+		GstSample *stale = data->nn_latest_sample.exchange(sample);
+		if (stale) {
+			gst_sample_unref(stale);
+			data->nn_dropped_samples++;
 		} else {
-			/* Execute the inference */
-			nn_inference(info.data);
+			/* The mailbox was empty, wake the NN thread up */
+			sem_post(&data->nn_sample_sem);
 		}
-		nn_postprocessing();
-		gst_buffer_unmap(app_buffer, &info);
-		gst_buffer_unref (app_buffer);
-
-		/* We don't need the appsink sample anymore */
-		gst_sample_unref (sample);
-
-		/* Call application callback only in playing state */
-		gst_element_post_message(sink,
-					 			gst_message_new_application(GST_OBJECT(sink),
-								gst_structure_new_empty("inference-done")));
-
 		return GST_FLOW_OK;
 	}
 
@@ -1916,13 +1946,6 @@ int main(int argc, char *argv[])
 
 	process_args(argc, argv);
 
-	/* Get number of CPU cores available */
-	uint8_t nb_cpu_cores = 1;
-	const auto processor_count = std::thread::hardware_concurrency();
-	std::cout << processor_count << " cpu core(s) available\n";
-	if (processor_count)
-		nb_cpu_cores = (uint8_t)processor_count;
-
 	/* Initialize our data structure */
 	data.pipeline = NULL;
 	data.pipeline_nn = NULL;
@@ -1941,7 +1964,6 @@ int main(int argc, char *argv[])
 	config.labels_file_name = labels_file_str;
 	config.input_mean = input_mean;
 	config.input_std = input_std;
-	config.number_of_threads = nb_cpu_cores;
 	config.number_of_results = 5;
 	stai_mpu_wrapper.Initialize(&config);
 
@@ -1956,6 +1978,8 @@ int main(int argc, char *argv[])
 	}
 	if (isMobilenet_v2 != std::string::npos){
 		results.model_type = "ssd_mobilenet_v2";
+		ssd_post_processor.Initialize(stai_mpu_wrapper.m_output_infos, MAX_DETECTIONS, NMS_TOP_K,
+						      stai_mpu_wrapper.GetBackendEngine());
 	}
 
 	/* Recover labels from label file */
@@ -2033,6 +2057,9 @@ int main(int argc, char *argv[])
 	/* Create the GUI containing the video stream  */
 	gui_create_main(&data);
 	if (data.preview_enabled) {
+		/* Start the NN inference thread before the first camera sample */
+		sem_init(&data.nn_sample_sem, 0, 0);
+		data.nn_thread = std::thread(nn_thread_loop, &data);
 		g_print("gst set pipeline playing state\n");
 		gst_element_set_state (data.pipeline, GST_STATE_PLAYING);
 	}
@@ -2053,12 +2080,36 @@ int main(int argc, char *argv[])
 	gtk_main();
 	gtk_main_started = false;
 
+	if (verbose) {
+		stai_mpu_network_stats stats = stai_mpu_wrapper.GetStats();
+		g_print("Inference latency over %lu runs: mean %.2f ms, min %.2f ms, max %.2f ms, "
+			"p50 %.2f ms, p95 %.2f ms, p99 %.2f ms\n",
+			(unsigned long)stats.run.count, stats.run.mean_ms, stats.run.min_ms, stats.run.max_ms,
+			stats.run.p50_ms, stats.run.p95_ms, stats.run.p99_ms);
+		g_print("set_input p99 %.2f ms, get_output p99 %.2f ms\n",
+			stats.set_input.p99_ms, stats.get_output.p99_ms);
+		g_print("Model load %.2f ms, first run %.2f ms, %u warm-up runs\n",
+			stats.startup.load_ms, stats.startup.first_run_ms, stats.startup.warmup_runs);
+		if (data.preview_enabled)
+			g_print("Camera frames dropped while the NN was busy: %lu\n",
+				data.nn_dropped_samples.load());
+	}
+
 	/* Out of the main loop, clean up nicely */
 	if (data.preview_enabled) {
 		/* Camera preview use case */
 		g_print("Returned, stopping Gst pipeline\n");
 		gst_element_set_state(data.pipeline, GST_STATE_NULL);
 
+		/* No more sample can come, stop the NN inference thread */
+		data.nn_thread_exit = true;
+		sem_post(&data.nn_sample_sem);
+		data.nn_thread.join();
+		GstSample *sample = data.nn_latest_sample.exchange(nullptr);
+		if (sample)
+			gst_sample_unref(sample);
+		sem_destroy(&data.nn_sample_sem);
+
 		g_print("Deleting Gst pipeline\n");
 		gst_object_unref(data.pipeline);
 	}
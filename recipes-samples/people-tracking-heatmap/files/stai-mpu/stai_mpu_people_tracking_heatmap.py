@@ -188,9 +188,10 @@ class GstPipeline():
             if(self.app.loading_nn):
                 self.app.loading_nn = False
 
-    def gst_to_nparray(self,sample):
+    def gst_to_nparray(self,sample,data):
         """
-        conversion of the gstreamer frame buffer into numpy array
+        conversion of the gstreamer frame buffer into a numpy array viewing
+        the mapped buffer data, only valid until the buffer is unmapped
         """
         buf = sample.get_buffer()
         if(args.debug):
@@ -210,7 +211,7 @@ class GstPipeline():
             (number_of_lines,
              number_of_column,
              channels),
-            buffer=buf.extract_dup(0, buf.get_size()),
+            buffer=data,
             dtype=np.uint8)
         return arr
 
@@ -221,9 +222,15 @@ class GstPipeline():
         """
         global image_arr
         sample = self.appsink.emit("pull-sample")
-        arr = self.gst_to_nparray(sample)
+        buf = sample.get_buffer()
+        success, map_info = buf.map(Gst.MapFlags.READ)
+        if not success:
+            return Gst.FlowReturn.ERROR
+        arr = self.gst_to_nparray(sample, map_info.data)
         if arr is not None :
             self.nn.launch_inference(arr)
+            # the input has been copied into the model, the frame is not needed anymore
+            buf.unmap(map_info)
             self.app.nn_result_locations = self.nn.get_results()
 
             nn_result_copy = copy.deepcopy(self.app.nn_result_locations)
@@ -7,7 +7,7 @@
 # in the root directory of this software component.
 # If no LICENSE file comes with this software, it is provided AS-IS.
 
-from stai_mpu import stai_mpu_network
+from stai_mpu import stai_mpu_network, preprocess, nms
 from timeit import default_timer as timer
 from abc import ABC, abstractmethod
 from typing import Optional, TypeVar
@@ -57,6 +57,7 @@ class NeuralNetwork:
         # Read input tensor information
         self.num_inputs = self.stai_mpu_model.get_num_inputs()
         self.input_tensor_infos = self.stai_mpu_model.get_input_infos()
+        self._preprocess = preprocess.Preprocessor(self._input_mean, self._input_std)
 
         # Read output tensor information
         self.num_outputs = self.stai_mpu_model.get_num_outputs()
@@ -83,7 +84,7 @@ class NeuralNetwork:
 
         # preprocess input data if necessary
         if self.input_tensor_infos[0].get_dtype() == np.float32:
-            input_data = (np.float32(input_data) - self._input_mean) / self._input_std
+            input_data = self._preprocess(input_data)
 
         # set NN model input with input data
         self.stai_mpu_model.set_input(0, input_data)
@@ -95,34 +96,6 @@ class NeuralNetwork:
         inference_time = end - start
         return inference_time
 
-    def intersection(self, rect1, rect2):
-        """
-        This method return the intersection of two rectangles
-        """
-        rect1_x1,rect1_y1,rect1_x2,rect1_y2 = rect1[:4]
-        rect2_x1,rect2_y1,rect2_x2,rect2_y2 = rect2[:4]
-        x1 = max(rect1_x1,rect2_x1)
-        y1 = max(rect1_y1,rect2_y1)
-        x2 = min(rect1_x2,rect2_x2)
-        y2 = min(rect1_y2,rect2_y2)
-        return (x2-x1)*(y2-y1)
-
-    def union(self, rect1,rect2):
-        """
-        This method return the union of two rectangles
-        """
-        rect1_x1,rect1_y1,rect1_x2,rect1_y2 = rect1[:4]
-        rect2_x1,rect2_y1,rect2_x2,rect2_y2 = rect2[:4]
-        rect1_area = (rect1_x2-rect1_x1)*(rect1_y2-rect1_y1)
-        rect2_area = (rect2_x2-rect2_x1)*(rect2_y2-rect2_y1)
-        return rect1_area + rect2_area - self.intersection(rect1,rect2)
-
-    def iou(self, rect1,rect2):
-        """
-        This method compute IoU
-        """
-        return self.intersection(rect1,rect2)/self.union(rect1,rect2)
-
     def get_results(self):
          # Lists to hold respective values while unwrapping.
         base_objects_list = []
@@ -149,10 +122,12 @@ class NeuralNetwork:
             base_objects_list.append([left, top, right, bottom, score, class_id])
 
         # Do NMS
-        base_objects_list.sort(key=lambda x: x[4], reverse=True)
-        while len(base_objects_list)>0:
-            final_dets.append(base_objects_list[0])
-            base_objects_list = [objects for objects in base_objects_list if self.iou(objects,base_objects_list[0]) < self.iou_threshold]
+        if base_objects_list:
+            boxes = np.array([objects[:4] for objects in base_objects_list], dtype=np.float32)
+            scores = np.array([objects[4] for objects in base_objects_list], dtype=np.float32)
+            classes = np.array([objects[5] for objects in base_objects_list])
+            keep = nms.non_max_suppression(boxes, scores, self.iou_threshold, classes)
+            final_dets = [base_objects_list[i] for i in keep]
 
         return final_dets
 
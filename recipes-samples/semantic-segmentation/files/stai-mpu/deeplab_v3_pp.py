@@ -7,7 +7,7 @@
 # in the root directory of this software component.
 # If no LICENSE file comes with this software, it is provided AS-IS.
 
-from stai_mpu import stai_mpu_network
+from stai_mpu import stai_mpu_network, preprocess
 import numpy as np
 from timeit import default_timer as timer
 
@@ -73,6 +73,7 @@ class NeuralNetwork:
         # Read input tensor information
         self.num_inputs = self.stai_mpu_model.get_num_inputs()
         self.input_tensor_infos = self.stai_mpu_model.get_input_infos()
+        self._preprocess = preprocess.Preprocessor(self._input_mean, self._input_std)
 
         # Read input tensor information
         self.num_outputs = self.stai_mpu_model.get_num_outputs()
@@ -115,7 +116,7 @@ class NeuralNetwork:
         input_data = np.expand_dims(img, axis=0)
 
         if self._floating_model:
-            input_data = (np.float32(input_data) - self._input_mean) / self._input_std
+            input_data = self._preprocess(input_data)
 
         self.stai_mpu_model.set_input(0, input_data)
         start = timer()
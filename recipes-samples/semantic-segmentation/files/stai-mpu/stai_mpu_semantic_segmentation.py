@@ -214,9 +214,10 @@ class GstWidget(Gtk.Box):
             self.app.draw_inference = True
             self.app.update_ui()
 
-    def preprocess_buffer(self,sample):
+    def preprocess_buffer(self,sample,data):
         """
-        conversion of the gstreamer frame buffer into numpy array
+        conversion of the gstreamer frame buffer into a numpy array viewing
+        the mapped buffer data, only valid until the buffer is unmapped
         """
         buf = sample.get_buffer()
         if(args.debug):
@@ -232,7 +233,7 @@ class GstWidget(Gtk.Box):
         number_of_column = caps.get_structure(0).get_value('width')
         number_of_lines = caps.get_structure(0).get_value('height')
         channels = 3
-        buffer = np.frombuffer(buf.extract_dup(0, buf.get_size()), dtype=np.uint8)
+        buffer = np.frombuffer(data, dtype=np.uint8)
 
         #DCMIPP pixelpacker has a constraint on the output resolution that should be multiple of 16.
         # the allocated buffer may contains stride to handle the DCMIPP Hw constraints/
@@ -241,21 +242,17 @@ class GstWidget(Gtk.Box):
         if (self.app.nn_input_width % 16 != 0):
             # Calculate the nearest upper multiple of 16
             upper_multiple = ((self.app.nn_input_width // 16) + 1) * 16
-            # Calculate the stride and offset
+            # Calculate the stride
             stride = upper_multiple * channels
-            offset = stride - (number_of_column * channels)
         else :
-            # Calculate the stride and offset
+            # Calculate the stride
             stride = number_of_column * channels
-            offset = 0
-        num_lines = len(buffer) // stride
-        arr = np.empty((number_of_column, number_of_lines, channels), dtype=np.uint8)
-        # Fill the processed buffer properly depending on stride and offset
-        for i in range(num_lines):
-            start_index = i * stride
-            end_index = start_index + (stride - offset)
-            line_data = buffer[start_index:end_index]
-            arr[i] = line_data.reshape((number_of_column, channels))
+        # View of the frame over the mapped buffer, the padding at the end of
+        # the rows being skipped through the strides instead of copying the rows
+        arr = np.lib.stride_tricks.as_strided(buffer,
+                                              shape=(number_of_lines, number_of_column, channels),
+                                              strides=(stride, channels, 1),
+                                              writeable=False)
         return arr
 
     def new_sample(self,*data):
@@ -264,21 +261,30 @@ class GstWidget(Gtk.Box):
         and run inference
         """
         sample = self.appsink.emit("pull-sample")
-        arr = self.preprocess_buffer(sample)
-        if(args.debug):
-            cv2.imwrite("/home/weston/NN_cv_sample_dump.png",arr)
-        self.last_picture = arr.copy()
-        if (args.validation):
-            if (arr is not None):
-                start_time = timer()
-                self.nn.launch_inference(arr)
-                stop_time = timer()
-                self.app.nn_inference_time = stop_time - start_time
-                self.app.nn_inference_fps = (1000/(self.app.nn_inference_time*1000))
-                self.app.unique_label, self.app.nn_seg_map = self.app.nn.get_results()
-                struc = Gst.Structure.new_empty("inference-done")
-                msg = Gst.Message.new_application(None, struc)
-                self.bus_pipeline.post(msg)
+        buf = sample.get_buffer()
+        success, map_info = buf.map(Gst.MapFlags.READ)
+        if not success:
+            return Gst.FlowReturn.ERROR
+        # the frame is only mapped while it is read, the buffer being unmapped
+        # even when the preprocessing or the inference raises
+        try:
+            arr = self.preprocess_buffer(sample, map_info.data)
+            if(args.debug):
+                cv2.imwrite("/home/weston/NN_cv_sample_dump.png",arr)
+            self.last_picture = arr.copy()
+            if (args.validation):
+                if (arr is not None):
+                    start_time = timer()
+                    self.nn.launch_inference(arr)
+                    stop_time = timer()
+                    self.app.nn_inference_time = stop_time - start_time
+                    self.app.nn_inference_fps = (1000/(self.app.nn_inference_time*1000))
+                    self.app.unique_label, self.app.nn_seg_map = self.app.nn.get_results()
+                    struc = Gst.Structure.new_empty("inference-done")
+                    msg = Gst.Message.new_application(None, struc)
+                    self.bus_pipeline.post(msg)
+        finally:
+            buf.unmap(map_info)
         return Gst.FlowReturn.OK
 
     def get_fps_display(self,fpsdisplaysink,fps,droprate,avgfps):